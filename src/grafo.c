@@ -9,11 +9,37 @@
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
+#include <time.h>
 
 #include "grafo.h"
 
 #define MAX_VERTICES 1024
 
+// marca de posicao vazia na tabela de espalhamento de arestas
+#define HASH_VAZIO UINT_MAX
+
+// politicas de arestas copiadas para cada grafo criado (ver configura_arestas)
+static unsigned int politica_paralelas = PARALELAS_PRIMEIRA;
+static unsigned int politica_lacos = LACOS_MANTEM;
+
+// modo externo usado pelos grafos lidos (ver configura_modo_externo)
+// le_grafo passa os dois valores para o Externo do grafo ao criá-lo
+// (menor que Externo.dir para caber o sufixo do subdiretorio)
+static char dir_externo[MAX_LINHA - 32] = "";
+static size_t orcamento_externo = 0;
+
+// numero maximo de runs abertos ao mesmo tempo em uma intercalacao
+#define MAX_RUNS_ABERTOS 16
+
+// alinhamento (em bytes) das linhas da matriz de adjacencia, suficiente para AVX2
+#define ALINHAMENTO_MATRIZ 32
+
+// kernels vetoriais do Dijkstra denso; compile com -DGRAFO_SEM_SIMD para usar so os escalares
+#if !defined(GRAFO_SEM_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRAFO_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
 //------------------------------------------------------------------------------
 // Funcoes internas (declaracoes aqui devido as flags de compilacao usadas no makefile do trabalho)
 
@@ -26,21 +52,130 @@ int cmp_nome(const void *a, const void *b);
 // Funcao auxiliar para obter nome do vertice pelo id
 char *nome_vertice_por_id(grafo *g, unsigned int id);
 
-// bsuca auxilair para vertices de corte
-void dfs_vertices_corte(grafo *g, int v, int pai, int *visitado, int *pre_ordem, int *low_point, int *eh_corte, int *timer);
+// pre-ordem, low point e pai na arvore de busca de todos os vertices (usado nos cortes e nas arvores)
+void calcula_low_point(grafo *g, int *pai, int *pre_ordem, int *low_point);
+
+// Aloca um grafo vazio com o nome dado (copiado; pode ser NULL)
+grafo *cria_grafo(const char *nome);
+
+// Monta a matriz e as listas de adjacencia depois que vertices e arestas foram inseridos
+void finaliza_grafo(grafo *g);
+
+// Adiciona um vertice novo sem procurar por outro de mesmo nome
+Vertice *adiciona_vertice(grafo *g, const char *nome);
+
+// Vetor indexado por id com os vertices de g
+Vertice **vetor_vertices(grafo *g);
+
+// espalhamento de um par de ids de vertices
+unsigned int hash_par(unsigned int a, unsigned int b);
+
+// dobra a tabela de espalhamento de arestas e reinsere os indices
+void cresce_hash_arestas(grafo *g);
+
+// espalhamento (FNV-1a) do nome de um vertice
+unsigned int hash_nome(const char *nome);
+
+// dobra a tabela de espalhamento de vertices e reinsere os vertices
+void cresce_hash_vertices(grafo *g);
+
+// Compara arestas pelo par (id de v1, id de v2), usado em finaliza_grafo
+int cmp_arestas(const void *a, const void *b);
+
+// Modo externo: cria o estado e o diretorio dos arquivos de g dentro de diretorio
+void inicia_externo(grafo *g, const char *diretorio, size_t orcamento);
+
+// Modo externo: acumula uma aresta no buffer, gravando um run quando ele enche
+void adiciona_aresta_externa(grafo *g, Vertice *v1, Vertice *v2, int peso);
+
+// Modo externo: ordena o buffer, funde as repeticoes e grava como o proximo run
+void grava_run(grafo *g);
+
+// Modo externo: intercala todos os runs no arquivo final de arestas
+void finaliza_externo(grafo *g);
+
+// Modo externo: intercala os runs [ini, fim) em saida, devolve o numero de arestas gravadas
+unsigned int intercala_runs(grafo *g, unsigned int ini, unsigned int fim, const char *saida);
+
+// Modo externo: caminho de um arquivo dentro do diretorio de g (run k, ou o final se k == UINT_MAX)
+void caminho_externo(grafo *g, unsigned int k, char *caminho, size_t tam);
+
+// Modo externo: aplica a politica de paralelas fundindo b em a
+void funde_aresta_externa(unsigned int politica, ArestaExterna *a, const ArestaExterna *b);
+
+// Compara arestas externas por (v1, v2, ordem)
+int cmp_arestas_externas(const void *a, const void *b);
+
+// Modo externo: componentes e bipartição por union-find sobre o arquivo de arestas
+unsigned int n_componentes_externo(grafo *g);
+unsigned int bipartido_externo(grafo *g);
 
-// busca em profundidade para arestas de corte
-void dfs_arestas_corte(grafo *g, int v, int pai, int *visitado, int *pre_ordem, int *low_point, int *timer, char **arestas, unsigned int *count);
+// raiz de v no union-find com paridade; *par recebe a paridade de v em relacao a raiz
+unsigned int uf_raiz(unsigned int *pai, unsigned char *paridade, unsigned int v, unsigned int *par);
+
+// Modo externo: percorre o arquivo de arestas com union-find, devolve o numero de componentes
+unsigned int uf_externo(grafo *g, unsigned int *bip);
+
+// Modo externo: imprime as arestas do arquivo, no formato de imprime_grafo
+void imprime_arestas_externo(grafo *g);
+
+// Modo externo: informa em stderr que a operacao precisa do grafo em memoria
+int recusa_externo(grafo *g, const char *operacao);
+
+// monta as listas de adjacencia (CSR) a partir da matriz
+void monta_listas_adj(grafo *g);
+
+// busca em profundidade sobre as listas calculando pre-ordem, low point e pai na arvore
+void dfs_low_point(grafo *g, unsigned int v, int *pai, int *pre_ordem, int *low_point, int *timer);
+
+// soma duas distancias nao negativas, saturando em INF
+int soma_saturada(int a, int b);
+
+// aloca o estado de busca ponto a ponto de g
+Busca *cria_busca(grafo *g);
+
+// libera o estado de busca
+void destroi_busca(Busca *b);
+
+// invalida todas as distancias do estado de busca em O(1)
+void nova_epoca(Busca *b, unsigned int nv);
+
+// operacoes do heap minimo usado nas buscas
+void heap_insere(ItemHeap *h, unsigned int *tam, int dist, unsigned int v);
+ItemHeap heap_remove(ItemHeap *h, unsigned int *tam);
+
+// Dijkstra completo a partir de origem usando o estado de busca, devolve a excentricidade
+int varredura(grafo *g, unsigned int origem, unsigned int *componente, unsigned int *tam);
+
+// Compara limites de diametro, usado em limites_diametros
+int cmp_limites(const void *a, const void *b);
+
+// Aloca a matriz de adjacencia nv x nv zerada em um unico bloco alinhado
+void aloca_matriz(grafo *g);
+
+// indice do menor max(dist[i], mascara[i]) em [0, n), ou -1 se todos sao INF
+int argmin_mascarado(const int *dist, const int *mascara, unsigned int n);
+int argmin_mascarado_escalar(const int *dist, const int *mascara, unsigned int n);
+
+// dist[v] = min(dist[v], du + linha[v]) para linha[v] > 0, saturando em INF
+void relaxa_linha(int *dist, const int *linha, int du, unsigned int n);
+void relaxa_linha_escalar(int *dist, const int *linha, int du, unsigned int n);
+
+#ifdef GRAFO_SIMD_X86
+// nivel de SIMD disponivel na CPU: 2 = AVX2, 1 = SSE4.1, 0 = nenhum
+int nivel_simd(void);
+int argmin_mascarado_sse41(const int *dist, const int *mascara, unsigned int n);
+int argmin_mascarado_avx2(const int *dist, const int *mascara, unsigned int n);
+void relaxa_linha_sse41(int *dist, const int *linha, int du, unsigned int n);
+void relaxa_linha_avx2(int *dist, const int *linha, int du, unsigned int n);
+#endif
  
 //------------------------------------------------------------------------------
 // lê um grafo de f e o devolve
 grafo *le_grafo(FILE *f) {
   char linha[MAX_LINHA];
-  grafo *g = malloc(sizeof(grafo));
-  g->vertices = NULL;
-  g->arestas = NULL;
-  g->na = 0;
-  g->nv = 0;
+  grafo *g = cria_grafo(NULL);
+  if (dir_externo[0]) inicia_externo(g, dir_externo, orcamento_externo);
 
   // Nome do grafo
   while (fgets(linha, MAX_LINHA, f)) {
@@ -65,37 +200,37 @@ grafo *le_grafo(FILE *f) {
       if (sscanf(linha, " %255s -- %255s %d", nome1, nome2, &peso) >= 2) {
         Vertice *v1 = busca_ou_adiciona_vertice(g, nome1);
         Vertice *v2 = busca_ou_adiciona_vertice(g, nome2);
-        adiciona_aresta(g, v1, v2, peso);
+        if (g->externo) adiciona_aresta_externa(g, v1, v2, peso);
+        else adiciona_aresta(g, v1, v2, peso);
       }
     } else {
       busca_ou_adiciona_vertice(g, linha);
     }
   }
 
-  //Cria um matriz de adjacencia nv x nv
-  //Aloca vetor de pronteiros
-  g->matriz_adj = malloc(sizeof(int *) * g->nv+1);
-  if(!g->matriz_adj){perror("Erro ao alocar matriz de adjacencia\n"); exit(-1);}
+  if (g->externo) finaliza_externo(g);
+  else finaliza_grafo(g);
+  return g;
+}
 
-  //Aloca vetor de inteiros
-  for(unsigned int i=0; i<g->nv; i++){
-    g->matriz_adj[i] = calloc(g->nv+1, sizeof(int));
-    if(!g->matriz_adj[i]){perror("Erro ao alocar matriz de adjacencia\n"); exit(-1);}
-  }
-  
-  //Preenche a matriz (cria ela espelhada)
-  for (Aresta *a = g->arestas; a != NULL; a = a->prox){
-    //Quando uma aresta nao tem peso, insere o valor 1 na matriz para indicar que existe uma aresta ali
-    if(!a->peso){ 
-      g->matriz_adj[a->v1->id][a->v2->id] = 1;
-      g->matriz_adj[a->v2->id][a->v1->id] = 1;  
-    }
-    else{
-      g->matriz_adj[a->v1->id][a->v2->id] = a->peso;
-      g->matriz_adj[a->v2->id][a->v1->id] = a->peso;
-    }
+//------------------------------------------------------------------------------
+// configura como os próximos grafos lidos/criados tratam arestas repetidas
+
+void configura_arestas(unsigned int paralelas, unsigned int lacos) {
+  politica_paralelas = paralelas;
+  politica_lacos = lacos;
+}
+
+//------------------------------------------------------------------------------
+// liga o modo externo para os próximos grafos lidos por le_grafo()
+
+void configura_modo_externo(const char *diretorio, size_t orcamento) {
+  if (!diretorio) {
+    dir_externo[0] = '\0';
+    return;
   }
-  return g;
+  snprintf(dir_externo, sizeof(dir_externo), "%s", diretorio);
+  orcamento_externo = orcamento;
 }
 
 //------------------------------------------------------------------------------
@@ -117,21 +252,32 @@ unsigned int destroi_grafo(grafo *g){
     v = aux;
   }
   
+  free(g->hash_vertices);
+  
   //Free arestas
-  Aresta *bkp, *a=g->arestas;
-  while(a){
-    bkp = a->prox;
-    free(a);
-    a = bkp;
+  free(g->arestas);
+  free(g->hash_arestas);
+
+  //Remove os arquivos do modo externo
+  if (g->externo) {
+    char caminho[MAX_LINHA + 32];
+    caminho_externo(g, UINT_MAX, caminho, sizeof(caminho));
+    remove(caminho);
+    remove(g->externo->dir);
+    free(g->externo->buffer);
+    free(g->externo);
   }
 
-  //Free vetor de inteiros
-  for(unsigned int i=0; i<g->nv; i++)
-    free(g->matriz_adj[i]);
-
-  //Free Matriz adj
+  //Free bloco de inteiros e vetor de linhas da matriz adj
+  free(g->matriz_bloco);
   free(g->matriz_adj);
 
+  //Free listas de adjacencia e estado de busca
+  free(g->adj_inicio);
+  free(g->adj_vizinho);
+  free(g->adj_peso);
+  destroi_busca(g->busca);
+
   //Free grafo
   free(g);
   return 1;
@@ -155,6 +301,7 @@ unsigned int n_vertices(grafo *g){
 //------------------------------------------------------------------------------
 // devolve 1 se g é bipartido e 0 caso contrário
 unsigned int bipartido(grafo *g) {
+    if (g->externo) return bipartido_externo(g);
 
     // Fila de vértices para BFS
     Vertice *fila[MAX_VERTICES];
@@ -177,7 +324,8 @@ unsigned int bipartido(grafo *g) {
                 Vertice *atual = fila[frente++];
 
                 // Percorre todas as arestas para achar vizinhos do vértice atual
-                for (Aresta *a = g->arestas; a != NULL; a = a->prox) {
+                for (unsigned int i = 0; i < g->na; i++) {
+                    Aresta *a = &g->arestas[i];
                     Vertice *vizinho = NULL;
 
                     if (a->v1 == atual) {
@@ -217,6 +365,7 @@ unsigned int n_arestas(grafo *g){
 // devolve o número de componentes em g
 unsigned int n_componentes(grafo *g){
   if (!g) return 0;
+  if (g->externo) return n_componentes_externo(g);
 
   // Vetor auxiliar, indica se o vertice 
   int *visitado = calloc(g->nv, sizeof(int));
@@ -241,6 +390,27 @@ unsigned int n_componentes(grafo *g){
 
 
 char *diametros(grafo *g) {
+  if (recusa_externo(g, "diametros")) return NULL;
+  if (g->diam_aproximado) {
+    unsigned int nl;
+    LimitesDiametro *lim = limites_diametros(g, &nl);
+
+    // cada entrada tem no maximo dois ints, ".." e um espaco
+    char *saida = malloc((size_t)nl * 26 + 1);
+    saida[0] = '\0';
+    for (unsigned int i = 0; i < nl; i++) {
+      char buf[26];
+      if (lim[i].inferior == lim[i].superior)
+        sprintf(buf, "%d", lim[i].inferior);
+      else
+        sprintf(buf, "%d..%d", lim[i].inferior, lim[i].superior);
+      strcat(saida, buf);
+      if (i < nl - 1) strcat(saida, " ");
+    }
+    free(lim);
+    return saida;
+  }
+
   int *visitado = calloc(g->nv, sizeof(int));
   int *dias = malloc(g->nv * sizeof(int));
   int nd = 0;
@@ -282,17 +452,27 @@ char *diametros(grafo *g) {
 // ordem alfabética, separados por brancos
 char *vertices_corte(grafo *g) {
   if (!g) return NULL;
-
-  unsigned int n = g->nv;                       //quant vertices
-  int *pre_ordem = calloc(n, sizeof(int));      //tempo q entra no vertice
-  int *low_point = calloc(n, sizeof(int));      //lowpoint do vertice na arborescencia
-  int *visitado = calloc(n, sizeof(int));       //bitmap se o vertice ja foi consumido na busca
-  int *eh_corte = calloc(n, sizeof(int));       //indica se o vertice eh de corte
-  int timer = 0;                                //tempo atual na exec 
-
-  // Inicia a dfs
-  for (int i = 0; (unsigned int)i < n; i++)
-    if (!visitado[i]) dfs_vertices_corte(g, i, -1, visitado, pre_ordem, low_point, eh_corte, &timer);
+  if (recusa_externo(g, "vertices_corte")) return NULL;
+
+  unsigned int n = g->nv;                           //quant vertices
+  int *pre_ordem = malloc(sizeof(int) * (n + 1));   //tempo q entra no vertice
+  int *low_point = malloc(sizeof(int) * (n + 1));   //lowpoint do vertice na arborescencia
+  int *pai = malloc(sizeof(int) * (n + 1));         //pai na arborescencia (-1 nas raizes)
+  int *eh_corte = calloc(n + 1, sizeof(int));       //indica se o vertice eh de corte
+  int *filhos = calloc(n + 1, sizeof(int));         //filhos das raizes na arborescencia
+
+  calcula_low_point(g, pai, pre_ordem, low_point);
+
+  // v e de corte se e raiz com mais de um filho, ou se nao e raiz e tem
+  // um filho u cujo low_point nao sobe acima de v
+  for (unsigned int u = 0; u < n; u++) {
+    if (pai[u] == -1) continue;
+    unsigned int v = (unsigned int)pai[u];
+    if (pai[v] == -1) filhos[v]++;
+    else if (low_point[u] >= pre_ordem[v]) eh_corte[v] = 1;
+  }
+  for (unsigned int v = 0; v < n; v++)
+    if (pai[v] == -1 && filhos[v] > 1) eh_corte[v] = 1;
 
   // Coleta nomes
   unsigned int count = 0;
@@ -318,8 +498,9 @@ char *vertices_corte(grafo *g) {
   //Libera a memoria
   free(pre_ordem);
   free(low_point); 
-  free(visitado); 
+  free(pai); 
   free(eh_corte); 
+  free(filhos);
   free(nomes);
   return resultado;
 }
@@ -333,17 +514,34 @@ char *vertices_corte(grafo *g) {
 
 char *arestas_corte(grafo *g) {
   if (!g) return NULL;
+  if (recusa_externo(g, "arestas_corte")) return NULL;
 
-  unsigned int n = g->nv;                         //quant vertices
-  int *pre_ordem = calloc(n, sizeof(int));        //pre-ordem do vertice na arvore
-  int *low_point = calloc(n, sizeof(int));        //lowpoint do vertice na arborescencia
-  int *visitado = calloc(n, sizeof(int));         //bitmap se o vertice ja foi consumido na busca
-  char **arestas = malloc(sizeof(char *) * g->na);
+  unsigned int n = g->nv;                           //quant vertices
+  int *pre_ordem = malloc(sizeof(int) * (n + 1));   //pre-ordem do vertice na arvore
+  int *low_point = malloc(sizeof(int) * (n + 1));   //lowpoint do vertice na arborescencia
+  int *pai = malloc(sizeof(int) * (n + 1));         //pai na arborescencia (-1 nas raizes)
+  char **arestas = malloc(sizeof(char *) * (g->na + 1));
   unsigned int count = 0;
-  int timer = 0;                                  //tempo atual na exec 
 
-  for (unsigned int i = 0; i < n; i++)
-    if (!visitado[i]) dfs_arestas_corte(g,(int) i, -1, visitado, pre_ordem, low_point, &timer, arestas, &count);
+  calcula_low_point(g, pai, pre_ordem, low_point);
+
+  // a aresta pai -- u e de corte se de u nao se alcanca nada acima do pai
+  for (unsigned int u = 0; u < n; u++) {
+    if (pai[u] == -1) continue;
+    unsigned int v = (unsigned int)pai[u];
+    if (low_point[u] > pre_ordem[v]) {
+      char *nome1 = nome_vertice_por_id(g, v);
+      char *nome2 = nome_vertice_por_id(g, u);
+      if (strcmp(nome1, nome2) > 0) {
+        char *tmp = nome1;
+        nome1 = nome2;
+        nome2 = tmp;
+      }
+      char buffer[512];
+      snprintf(buffer, sizeof(buffer), "%s %s", nome1, nome2);
+      arestas[count++] = strdup(buffer);
+    }
+  }
 
   qsort(arestas, count, sizeof(char *), cmp_nome);
 
@@ -362,11 +560,378 @@ char *arestas_corte(grafo *g) {
   //Libera memoria
   free(pre_ordem); 
   free(low_point); 
-  free(visitado); 
+  free(pai); 
   free(arestas);
   return resultado;
 }
 
+//------------------------------------------------------------------------------
+// devolve a distância entre os vértices de ids origem e destino em g
+//
+// Dijkstra bidirecional: alterna entre a busca a partir da origem e a busca a
+// partir do destino, expandindo sempre o lado com menor distancia no topo do heap
+// melhor guarda o menor caminho ja visto passando por um vertice alcancado
+// pelos dois lados; quando a soma dos topos alcanca melhor, ele e o minimo
+
+int distancia(grafo *g, unsigned int origem, unsigned int destino) {
+  if (!g || origem >= g->nv || destino >= g->nv) return INF;
+  if (recusa_externo(g, "distancia")) return INF;
+  if (origem == destino) return 0;
+
+  if (!g->busca) g->busca = cria_busca(g);
+  Busca *b = g->busca;
+  nova_epoca(b, g->nv);
+
+  unsigned int inicio[2] = {origem, destino};
+  for (int lado = 0; lado < 2; lado++) {
+    b->dist[lado][inicio[lado]] = 0;
+    b->marca[lado][inicio[lado]] = b->epoca;
+    heap_insere(b->heap[lado], &b->tam_heap[lado], 0, inicio[lado]);
+  }
+
+  int melhor = INF;
+  while (b->tam_heap[0] && b->tam_heap[1]) {
+    int topo0 = b->heap[0][0].dist, topo1 = b->heap[1][0].dist;
+    if (soma_saturada(topo0, topo1) >= melhor) break;
+
+    int lado = (topo0 <= topo1) ? 0 : 1;
+    int outro = 1 - lado;
+    ItemHeap it = heap_remove(b->heap[lado], &b->tam_heap[lado]);
+    unsigned int v = it.v;
+
+    //entrada desatualizada no heap (remocao preguicosa)
+    if (b->fechado[lado][v] == b->epoca || it.dist > b->dist[lado][v]) continue;
+    b->fechado[lado][v] = b->epoca;
+
+    for (unsigned int k = g->adj_inicio[v]; k < g->adj_inicio[v + 1]; k++) {
+      unsigned int u = g->adj_vizinho[k];
+      int nd = soma_saturada(it.dist, g->adj_peso[k]);
+
+      if (b->marca[lado][u] != b->epoca || nd < b->dist[lado][u]) {
+        b->dist[lado][u] = nd;
+        b->marca[lado][u] = b->epoca;
+        heap_insere(b->heap[lado], &b->tam_heap[lado], nd, u);
+      }
+
+      //u ja foi alcancado pelo outro lado: caminho origem -> destino passando por v-u
+      if (b->marca[outro][u] == b->epoca) {
+        int d = soma_saturada(nd, b->dist[outro][u]);
+        if (d < melhor) melhor = d;
+      }
+    }
+  }
+
+  return melhor;
+}
+
+//------------------------------------------------------------------------------
+// devolve a árvore de pontes de g
+//
+// as pontes sao as arestas pai-filho da arvore de busca com low_point[filho] > pre_ordem[pai];
+// os componentes sem elas sao coletados com uma busca que nao atravessa pontes
+
+grafo *arvore_pontes(grafo *g) {
+  if (!g) return NULL;
+  if (recusa_externo(g, "arvore_pontes")) return NULL;
+
+  unsigned int n = g->nv;
+  int *pai = malloc(sizeof(int) * (n + 1));
+  int *pre_ordem = malloc(sizeof(int) * (n + 1));
+  int *low_point = malloc(sizeof(int) * (n + 1));
+  int *comp = malloc(sizeof(int) * (n + 1));
+  unsigned int *pilha = malloc(sizeof(unsigned int) * (n + 1));
+  if (!pai || !pre_ordem || !low_point || !comp || !pilha){perror("Erro ao alocar arvore de pontes\n"); exit(-1);}
+
+  calcula_low_point(g, pai, pre_ordem, low_point);
+
+  //Rotula os componentes 2-aresta-conexos e guarda o menor nome de cada um
+  Vertice **vert = vetor_vertices(g);
+  char **rep = malloc(sizeof(char *) * (n + 1));
+  if (!rep){perror("Erro ao alocar arvore de pontes\n"); exit(-1);}
+  unsigned int nc = 0;
+  for (unsigned int i = 0; i < n; i++) comp[i] = -1;
+  for (unsigned int i = 0; i < n; i++) {
+    if (comp[i] != -1) continue;
+    unsigned int topo = 0;
+    pilha[topo++] = i;
+    comp[i] = (int)nc;
+    rep[nc] = vert[i]->nome;
+    while (topo) {
+      unsigned int v = pilha[--topo];
+      if (strcmp(vert[v]->nome, rep[nc]) < 0) rep[nc] = vert[v]->nome;
+      for (unsigned int k = g->adj_inicio[v]; k < g->adj_inicio[v + 1]; k++) {
+        unsigned int u = g->adj_vizinho[k];
+        int ponte = (pai[u] == (int)v && low_point[u] > pre_ordem[v]) ||
+                    (pai[v] == (int)u && low_point[v] > pre_ordem[u]);
+        if (ponte || comp[u] != -1) continue;
+        comp[u] = (int)nc;
+        pilha[topo++] = u;
+      }
+    }
+    nc++;
+  }
+
+  //Monta a arvore: um vertice por componente, uma aresta por ponte
+  char nome_t[MAX_LINHA];
+  snprintf(nome_t, sizeof(nome_t), "%s_pontes", g->nome ? g->nome : "");
+  grafo *t = cria_grafo(nome_t);
+  t->politica_paralelas = g->politica_paralelas;
+  t->politica_lacos = g->politica_lacos;
+  Vertice **vc = malloc(sizeof(Vertice *) * (nc + 1));
+  if (!vc){perror("Erro ao alocar arvore de pontes\n"); exit(-1);}
+  for (unsigned int c = 0; c < nc; c++) vc[c] = adiciona_vertice(t, rep[c]);
+
+  for (unsigned int u = 0; u < n; u++) {
+    if (pai[u] == -1) continue;
+    unsigned int p = (unsigned int)pai[u];
+    if (low_point[u] > pre_ordem[p])
+      adiciona_aresta(t, vc[comp[p]], vc[comp[u]], g->matriz_adj[p][u]);
+  }
+  finaliza_grafo(t);
+
+  free(pai);
+  free(pre_ordem);
+  free(low_point);
+  free(comp);
+  free(pilha);
+  free(vert);
+  free(rep);
+  free(vc);
+  return t;
+}
+
+//------------------------------------------------------------------------------
+// devolve a árvore de blocos e vértices de corte de g
+//
+// os blocos saem dos mesmos dados de low point dos cortes: percorrendo os vertices
+// em pre-ordem, a aresta pai -- u abre um bloco novo se low_point[u] >= pre_ordem[pai]
+// (o pai entra nesse bloco tambem); senao u fica no bloco da aresta que chega ao pai
+// uma raiz sem filhos (isolada, ou so com laco) forma um bloco sozinha
+// cada par (vertice, bloco) e guardado em membro_v/membro_b; um vertice que
+// aparece em mais de um bloco e de corte
+
+grafo *arvore_blocos(grafo *g) {
+  if (!g) return NULL;
+  if (recusa_externo(g, "arvore_blocos")) return NULL;
+
+  unsigned int n = g->nv;
+  int *pai = malloc(sizeof(int) * (n + 1));
+  int *pre_ordem = malloc(sizeof(int) * (n + 1));
+  int *low_point = malloc(sizeof(int) * (n + 1));
+  unsigned int *ordem = malloc(sizeof(unsigned int) * (n + 1));
+  unsigned int *bloco = malloc(sizeof(unsigned int) * (n + 1));
+  int *tem_filho = calloc(n + 1, sizeof(int));
+  //cada vertice entra no bloco da aresta que chega nele e, no maximo, em um bloco por filho que abre bloco: <= 2V
+  unsigned int *membro_v = malloc(sizeof(unsigned int) * (2 * n + 1));
+  unsigned int *membro_b = malloc(sizeof(unsigned int) * (2 * n + 1));
+  unsigned int *n_blocos_v = calloc(n + 1, sizeof(unsigned int));
+  if (!pai || !pre_ordem || !low_point || !ordem || !bloco || !tem_filho || !membro_v || !membro_b || !n_blocos_v){
+    perror("Erro ao alocar arvore de blocos\n"); exit(-1);
+  }
+  unsigned int n_membros = 0, n_blocos = 0;
+
+  calcula_low_point(g, pai, pre_ordem, low_point);
+  for (unsigned int v = 0; v < n; v++) {
+    ordem[pre_ordem[v]] = v;
+    if (pai[v] != -1) tem_filho[pai[v]] = 1;
+  }
+
+  for (unsigned int i = 0; i < n; i++) {
+    unsigned int u = ordem[i];
+    if (pai[u] == -1) {
+      if (!tem_filho[u]) {
+        membro_v[n_membros] = u;
+        membro_b[n_membros++] = n_blocos++;
+      }
+      continue;
+    }
+    unsigned int p = (unsigned int)pai[u];
+    if (low_point[u] >= pre_ordem[p]) {
+      bloco[u] = n_blocos++;
+      membro_v[n_membros] = p;
+      membro_b[n_membros++] = bloco[u];
+    }
+    else
+      bloco[u] = bloco[p];  //p nao e raiz aqui: os filhos da raiz sempre abrem bloco
+    membro_v[n_membros] = u;
+    membro_b[n_membros++] = bloco[u];
+  }
+
+  for (unsigned int k = 0; k < n_membros; k++) n_blocos_v[membro_v[k]]++;
+
+  //Prefixo dos blocos que nenhum vertice de corte usa: "bloco_", "bloco__", ...
+  Vertice **vert = vetor_vertices(g);
+  char prefixo[MAX_LINHA + 8] = "bloco_";
+  size_t tam_prefixo = strlen(prefixo);
+  int conflito = 1;
+  while (conflito) {
+    conflito = 0;
+    for (unsigned int v = 0; v < n && !conflito; v++)
+      if (n_blocos_v[v] > 1 && strncmp(vert[v]->nome, prefixo, tam_prefixo) == 0) conflito = 1;
+    if (conflito) {
+      prefixo[tam_prefixo++] = '_';
+      prefixo[tam_prefixo] = '\0';
+    }
+  }
+
+  //Monta a arvore: um vertice por bloco e um por vertice de corte
+  char nome_t[MAX_LINHA];
+  snprintf(nome_t, sizeof(nome_t), "%s_blocos", g->nome ? g->nome : "");
+  grafo *t = cria_grafo(nome_t);
+  t->politica_paralelas = g->politica_paralelas;
+  t->politica_lacos = g->politica_lacos;
+
+  Vertice **vb = malloc(sizeof(Vertice *) * (n_blocos + 1));
+  Vertice **vcorte = calloc(n + 1, sizeof(Vertice *));
+  if (!vb || !vcorte){perror("Erro ao alocar arvore de blocos\n"); exit(-1);}
+  for (unsigned int b = 0; b < n_blocos; b++) {
+    char nome_b[MAX_LINHA + 32];
+    snprintf(nome_b, sizeof(nome_b), "%s%u", prefixo, b + 1);
+    vb[b] = adiciona_vertice(t, nome_b);
+  }
+
+  for (unsigned int k = 0; k < n_membros; k++) {
+    unsigned int v = membro_v[k];
+    if (n_blocos_v[v] < 2) continue;
+    if (!vcorte[v]) vcorte[v] = adiciona_vertice(t, vert[v]->nome);
+    adiciona_aresta(t, vcorte[v], vb[membro_b[k]], 0);
+  }
+  finaliza_grafo(t);
+
+  free(pai);
+  free(pre_ordem);
+  free(low_point);
+  free(ordem);
+  free(bloco);
+  free(tem_filho);
+  free(membro_v);
+  free(membro_b);
+  free(n_blocos_v);
+  free(vb);
+  free(vcorte);
+  free(vert);
+  return t;
+}
+
+//------------------------------------------------------------------------------
+// devolve a excentricidade do vértice de id v em g
+
+int excentricidade(grafo *g, unsigned int v) {
+  if (!g || v >= g->nv) return INF;
+  if (recusa_externo(g, "excentricidade")) return INF;
+  return varredura(g, v, NULL, NULL);
+}
+
+//------------------------------------------------------------------------------
+// configura o cálculo dos diâmetros de g
+
+void configura_diametros(grafo *g, unsigned int aproximado, unsigned int max_buscas, double max_segundos) {
+  if (!g) return;
+  g->diam_aproximado = aproximado;
+  g->diam_max_buscas = max_buscas;
+  g->diam_max_segundos = max_segundos;
+}
+
+//------------------------------------------------------------------------------
+// devolve limites inferior e superior do diâmetro de cada componente de g
+//
+// para cada vertice u do componente mantem lo[u] <= exc(u) <= hi[u]; apos uma
+// travessia a partir de s, com e = exc(s) e d = dist(s, u), pela desigualdade
+// triangular vale max(d, e - d) <= exc(u) <= e + d
+// o diametro fica entre o maior lo e o maior hi; a proxima origem alterna entre
+// o vertice de maior hi e o de menor lo ainda nao exatos (a primeira escolha e o
+// vertice mais distante da origem inicial, ou seja, a varredura dupla)
+
+LimitesDiametro *limites_diametros(grafo *g, unsigned int *n) {
+  *n = 0;
+  if (!g) return NULL;
+  if (recusa_externo(g, "limites_diametros")) return NULL;
+
+  unsigned int nv = g->nv;
+  LimitesDiametro *lim = malloc(sizeof(LimitesDiametro) * (nv + 1));
+  unsigned int *componente = malloc(sizeof(unsigned int) * (nv + 1));
+  int *visitado = calloc(nv + 1, sizeof(int));
+  int *lo = malloc(sizeof(int) * (nv + 1));
+  int *hi = malloc(sizeof(int) * (nv + 1));
+  if (!lim || !componente || !visitado || !lo || !hi){perror("Erro ao alocar limites de diametro\n"); exit(-1);}
+
+  //orcamento de tempo medido em tempo de relogio (monotonico), nao de CPU
+  struct timespec inicio, agora;
+  clock_gettime(CLOCK_MONOTONIC, &inicio);
+  if (!g->busca) g->busca = cria_busca(g);
+  int *dist = g->busca->dist[0];
+
+  for (unsigned int v = 0; v < nv; v++) {
+    if (visitado[v]) continue;
+
+    //A primeira travessia tambem descobre os vertices do componente
+    unsigned int tam = 0;
+    unsigned int s = v;
+    int d_lo = 0, d_hi = INF;
+    unsigned int buscas = 0;
+    int escolhe_maior_hi = 1;
+
+    while (1) {
+      int exc = varredura(g, s, buscas ? NULL : componente, buscas ? NULL : &tam);
+      buscas++;
+
+      if (buscas == 1) {
+        for (unsigned int i = 0; i < tam; i++) {
+          visitado[componente[i]] = 1;
+          lo[componente[i]] = 0;
+          hi[componente[i]] = INF;
+        }
+      }
+
+      //Atualiza os limites de cada vertice e do diametro
+      d_hi = 0;
+      for (unsigned int i = 0; i < tam; i++) {
+        unsigned int u = componente[i];
+        int d = dist[u];
+        int l = (d > exc - d) ? d : exc - d;
+        int h = soma_saturada(exc, d);
+        if (l > lo[u]) lo[u] = l;
+        if (h < hi[u]) hi[u] = h;
+        if (lo[u] > d_lo) d_lo = lo[u];
+        if (hi[u] > d_hi) d_hi = hi[u];
+      }
+
+      if (d_lo >= d_hi) { d_hi = d_lo; break; }
+      if (g->diam_max_buscas && buscas >= g->diam_max_buscas) break;
+      if (g->diam_max_segundos > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &agora);
+        double decorrido = (double)(agora.tv_sec - inicio.tv_sec) +
+                           (double)(agora.tv_nsec - inicio.tv_nsec) / 1e9;
+        if (decorrido >= g->diam_max_segundos) break;
+      }
+
+      //Escolhe a proxima origem entre os vertices de excentricidade ainda incerta
+      int achou = 0;
+      for (unsigned int i = 0; i < tam; i++) {
+        unsigned int u = componente[i];
+        if (lo[u] == hi[u]) continue;
+        if (!achou || (escolhe_maior_hi ? hi[u] > hi[s] : lo[u] < lo[s])) s = u;
+        achou = 1;
+      }
+      if (!achou) { d_hi = d_lo; break; }
+      escolhe_maior_hi = !escolhe_maior_hi;
+    }
+
+    lim[*n].inferior = d_lo;
+    lim[*n].superior = d_hi;
+    lim[*n].buscas = buscas;
+    (*n)++;
+  }
+
+  qsort(lim, *n, sizeof(LimitesDiametro), cmp_limites);
+
+  free(componente);
+  free(visitado);
+  free(lo);
+  free(hi);
+  return lim;
+}
+
 //------------------------------------------------------------------------------
 //funções auxiliares
 
@@ -399,43 +964,158 @@ Vertice *cria_vertice(const char *nome){
 }
 
 // busca ou adiciona um vértice no grafo
+// a busca usa a tabela de espalhamento por nome, entao custa O(1) esperado
 Vertice *busca_ou_adiciona_vertice(grafo *g, const char *nome) {
-  Vertice *v = g->vertices;
-  while (v) {
-    if (strcmp(v->nome, nome) == 0) //Se ja existe um vert com esse nome, retorna ele
-      return v;
-    v = v->prox;
+  if (g->cap_hash_vertices) {
+    unsigned int h = hash_nome(nome) & (g->cap_hash_vertices - 1);
+    while (g->hash_vertices[h]) {
+      if (strcmp(g->hash_vertices[h]->nome, nome) == 0) //Se ja existe um vert com esse nome, retorna ele
+        return g->hash_vertices[h];
+      h = (h + 1) & (g->cap_hash_vertices - 1);
+    }
   }
-  Vertice *novo = cria_vertice(nome); //Se n existe, cria um novo
+  return adiciona_vertice(g, nome); //Se n existe, cria um novo
+}
+
+// Adiciona um vertice novo sem procurar por outro de mesmo nome
+Vertice *adiciona_vertice(grafo *g, const char *nome) {
+  Vertice *novo = cria_vertice(nome);
   if(!novo){perror("Erro de alocacao ao criar vertice.\n"); exit(-1);}
   novo->id = g->nv;
   novo->prox = g->vertices;
   g->vertices = novo;
   g->nv ++;
+
+  //Insere na tabela de nomes (mantida com ocupacao de no maximo 1/2)
+  if (2 * g->nv > g->cap_hash_vertices) cresce_hash_vertices(g);
+  else {
+    unsigned int h = hash_nome(novo->nome) & (g->cap_hash_vertices - 1);
+    while (g->hash_vertices[h]) h = (h + 1) & (g->cap_hash_vertices - 1);
+    g->hash_vertices[h] = novo;
+  }
   return novo;
 }
 
+// Vetor indexado por id com os vertices de g (deve ser liberado com free)
+Vertice **vetor_vertices(grafo *g) {
+  Vertice **vert = malloc(sizeof(Vertice *) * (g->nv + 1));
+  if (!vert){perror("Erro ao alocar vetor de vertices\n"); exit(-1);}
+  for (Vertice *v = g->vertices; v != NULL; v = v->prox)
+    vert[v->id] = v;
+  return vert;
+}
+
 // cria e adiciona uma aresta
+// uma aresta paralela a outra ja inserida apenas atualiza o peso dela, segundo
+// a politica de g; lacos podem ser descartados
 void adiciona_aresta(grafo *g, Vertice *v1, Vertice *v2, int peso) {
-  Aresta *a = malloc(sizeof(Aresta));
-  if(!a){perror("Erro de alocacao ao criar aresta.\n"); exit(-1);}
+  if (v1 == v2 && g->politica_lacos == LACOS_DESCARTA) return;
+  if (v1->id > v2->id) {
+    Vertice *tmp = v1;
+    v1 = v2;
+    v2 = tmp;
+  }
+
+  //Procura o par na tabela (mantida com ocupacao de no maximo 1/2)
+  if (2 * (g->na + 1) > g->cap_hash) cresce_hash_arestas(g);
+  unsigned int h = hash_par(v1->id, v2->id) & (g->cap_hash - 1);
+  while (g->hash_arestas[h] != HASH_VAZIO) {
+    Aresta *a = &g->arestas[g->hash_arestas[h]];
+    if (a->v1 == v1 && a->v2 == v2) { //aresta paralela: funde
+      if (g->politica_paralelas == PARALELAS_ULTIMA ||
+          (g->politica_paralelas == PARALELAS_MENOR && peso < a->peso) ||
+          (g->politica_paralelas == PARALELAS_MAIOR && peso > a->peso))
+        a->peso = peso;
+      return;
+    }
+    h = (h + 1) & (g->cap_hash - 1);
+  }
+
+  if (g->na == g->cap_arestas) {
+    g->cap_arestas = g->cap_arestas ? 2 * g->cap_arestas : 16;
+    g->arestas = realloc(g->arestas, sizeof(Aresta) * g->cap_arestas);
+    if(!g->arestas){perror("Erro de alocacao ao criar aresta.\n"); exit(-1);}
+  }
+  Aresta *a = &g->arestas[g->na];
   a->v1 = v1;
   a->v2 = v2;
   a->peso = peso;
-  a->prox = g->arestas;
-  g->arestas = a;
+  g->hash_arestas[h] = g->na;
   g->na ++;
 }
 
+// espalhamento de um par de ids de vertices
+unsigned int hash_par(unsigned int a, unsigned int b) {
+  unsigned int h = a * 0x9E3779B1u ^ (b + 0x7F4A7C15u + (a << 6) + (a >> 2));
+  h ^= h >> 16;
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  return h;
+}
+
+// dobra a tabela de espalhamento de arestas e reinsere os indices
+void cresce_hash_arestas(grafo *g) {
+  free(g->hash_arestas);
+  g->cap_hash = g->cap_hash ? 2 * g->cap_hash : 32;
+  g->hash_arestas = malloc(sizeof(unsigned int) * g->cap_hash);
+  if(!g->hash_arestas){perror("Erro de alocacao ao criar aresta.\n"); exit(-1);}
+  for (unsigned int i = 0; i < g->cap_hash; i++) g->hash_arestas[i] = HASH_VAZIO;
+
+  for (unsigned int i = 0; i < g->na; i++) {
+    unsigned int h = hash_par(g->arestas[i].v1->id, g->arestas[i].v2->id) & (g->cap_hash - 1);
+    while (g->hash_arestas[h] != HASH_VAZIO) h = (h + 1) & (g->cap_hash - 1);
+    g->hash_arestas[h] = i;
+  }
+}
+
+// espalhamento (FNV-1a) do nome de um vertice
+unsigned int hash_nome(const char *nome) {
+  unsigned int h = 2166136261u;
+  for (const unsigned char *c = (const unsigned char *)nome; *c; c++) {
+    h ^= *c;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+// dobra a tabela de espalhamento de vertices e reinsere todos (inclusive o recem criado)
+void cresce_hash_vertices(grafo *g) {
+  free(g->hash_vertices);
+  g->cap_hash_vertices = g->cap_hash_vertices ? 2 * g->cap_hash_vertices : 32;
+  g->hash_vertices = calloc(g->cap_hash_vertices, sizeof(Vertice *));
+  if(!g->hash_vertices){perror("Erro de alocacao ao criar vertice.\n"); exit(-1);}
+
+  for (Vertice *v = g->vertices; v != NULL; v = v->prox) {
+    unsigned int h = hash_nome(v->nome) & (g->cap_hash_vertices - 1);
+    while (g->hash_vertices[h]) h = (h + 1) & (g->cap_hash_vertices - 1);
+    g->hash_vertices[h] = v;
+  }
+}
+
+// Compara arestas pelo par (id de v1, id de v2), usado em finaliza_grafo
+int cmp_arestas(const void *a, const void *b) {
+  const Aresta *aa = a;
+  const Aresta *ab = b;
+  if (aa->v1->id != ab->v1->id) return (aa->v1->id < ab->v1->id) ? -1 : 1;
+  if (aa->v2->id != ab->v2->id) return (aa->v2->id < ab->v2->id) ? -1 : 1;
+  return 0;
+}
+
 void imprime_grafo(grafo *g) {
   printf("Grafo: %s\n", g->nome);
   printf("Vértices:\n");
   for (Vertice *v = g->vertices; v != NULL; v = v->prox)
     printf("  %s\n", v->nome);
 
+  //No modo externo as arestas saem do arquivo, na ordem (id de v1, id de v2), e nao ha matriz
+  if (g->externo) {
+    imprime_arestas_externo(g);
+    return;
+  }
+
   printf("Arestas:\n");
-  for (Aresta *a = g->arestas; a != NULL; a = a->prox)
-    printf("  %s -- %s (%d)\n", a->v1->nome, a->v2->nome, a->peso);
+  for (unsigned int i = 0; i < g->na; i++)
+    printf("  %s -- %s (%d)\n", g->arestas[i].v1->nome, g->arestas[i].v2->nome, g->arestas[i].peso);
 
   //imprime matriz de adjacencia
   printf("Matriz de adj:\n\n");
@@ -469,88 +1149,54 @@ void dfs_n_comp(unsigned int v, int *visitado, grafo *g) {
   }
 }
 
-// bsuca auxilair para vertices de corte
-void dfs_vertices_corte(grafo *g, int v, int pai, int *visitado, int *pre_ordem, int *low_point, int *eh_corte, int *timer) {
-  visitado[v] = 1;
+// pre-ordem, low point e pai na arvore de busca de todos os vertices
+// e o calculo comum a vertices_corte, arestas_corte e as arvores de pontes e de blocos
+void calcula_low_point(grafo *g, int *pai, int *pre_ordem, int *low_point) {
+  int timer = 0;
+  for (unsigned int i = 0; i < g->nv; i++) pre_ordem[i] = -1;
+  for (unsigned int i = 0; i < g->nv; i++)
+    if (pre_ordem[i] == -1) {
+      pai[i] = -1;
+      dfs_low_point(g, i, pai, pre_ordem, low_point, &timer);
+    }
+}
+
+// busca em profundidade sobre as listas calculando pre-ordem, low point e pai na arvore
+// pre_ordem[u] == -1 indica vertice ainda nao visitado; pai[v] deve estar preenchido
+void dfs_low_point(grafo *g, unsigned int v, int *pai, int *pre_ordem, int *low_point, int *timer) {
   pre_ordem[v] = low_point[v] = (*timer)++;
-  int filhos = 0;
 
-  for (int u = 0; (unsigned int)u < g->nv; u++) {
-    if (g->matriz_adj[v][u] == 0) continue;
-    if ((int)u == pai) continue;
+  for (unsigned int k = g->adj_inicio[v]; k < g->adj_inicio[v + 1]; k++) {
+    unsigned int u = g->adj_vizinho[k];
+    if ((int)u == pai[v]) continue; //aresta com o pai ja foi processada
 
-    if (visitado[u]) {
+    if (pre_ordem[u] != -1) {
       if (pre_ordem[u] < low_point[v]) low_point[v] = pre_ordem[u];
     }
     else {
-      dfs_vertices_corte(g, u, v, visitado, pre_ordem, low_point, eh_corte, timer);
+      pai[u] = (int)v;
+      dfs_low_point(g, u, pai, pre_ordem, low_point, timer);
       if (low_point[u] < low_point[v]) low_point[v] = low_point[u];
-      if (low_point[u] >= pre_ordem[v] && pai != -1) eh_corte[v] = 1;
-      filhos++;
     }
   }
-
-  if (pai == -1 && filhos > 1) eh_corte[v] = 1;
-}
-
-// busca em profundidade para arestas de corte
-void dfs_arestas_corte(grafo *g, int v, int pai, int *visitado, int *pre_ordem, int *low_point, int *timer, char **arestas, unsigned int *count){
-  visitado[v] = 1;    
-  pre_ordem[v] = low_point[v] = (*timer)++; //Atualiza pre_ordem e lowpoint atual
-
-  for (int u = 0; (unsigned int)u < g->nv; u++) { 
-    if (g->matriz_adj[v][u] == 0) continue; // se nao tem aresta pula
-    if ((int)u == pai) continue; //aresta com o pai ja foi processada
-
-    if (visitado[u]) { //se tem uma aresta com um vertice q ja foi processado, atualiza o lowpoint
-      if (pre_ordem[u] < low_point[v]) low_point[v] = pre_ordem[u];
-    } 
-    else { //Se a aresta eh com um vertice novo, consome esse novo vertice
-
-      dfs_arestas_corte(g, (int) u, v, visitado, pre_ordem, low_point, timer, arestas, count);
-      if (low_point[u] > pre_ordem[v]) {
-        // Encontrou aresta de corte v -- u
-        char *nome1 = nome_vertice_por_id(g, (unsigned int)v);
-        char *nome2 = nome_vertice_por_id(g, (unsigned int)u);
-        if (strcmp(nome1, nome2) > 0) {
-          char *tmp = nome1;
-          nome1 = nome2;
-          nome2 = tmp;
-        }
-        char buffer[512];
-        snprintf(buffer, sizeof(buffer), "%s %s", nome1, nome2);
-        arestas[(*count)++] = strdup(buffer);
-      }
-      if (low_point[u] < low_point[v]) low_point[v] = low_point[u];
-    }//else
-  }//for
 }
 
-
-
 // Função auxiliar: Dijkstra para calcular distâncias de um vértice origem
+// usa a matriz densa; a escolha do minimo e o relaxamento da linha sao feitos
+// pelos kernels vetoriais (os vertices ja fixados ficam com INF em usado)
 void dijkstra(grafo *g, int origem, int *dist) {
     unsigned int nv = g->nv;
-    unsigned int *usado = calloc(nv, sizeof(int));
+    int *usado = calloc(nv + 1, sizeof(int));
     for (unsigned int i = 0; i < nv; i++) dist[i] = INF;
     dist[origem] = 0;
 
     for (unsigned int count = 0; count < nv; count++) {
-        int u = -1;
-        for ( int i = 0; i < (int)nv; i++) {
-            if (!usado[i] && (u == -1 || dist[i] < dist[u])) u = i;
-        }
+        int u = argmin_mascarado(dist, usado, nv);
+        if (u == -1) break;  // componente desconectado
+        usado[u] = INF;
 
-        if (dist[u] == INF) break;  // componente desconectado
-        usado[u] = 1;
-
-        for (unsigned int v = 0; v < nv; v++) {
-            if (g->matriz_adj[u][v] > 0 && !usado[v]) {
-                if (dist[u] + g->matriz_adj[u][v] < dist[v]) {
-                    dist[v] = dist[u] + g->matriz_adj[u][v];
-                }
-            }
-        }
+        // vertices ja fixados tem dist <= dist[u], entao o relaxamento nao os altera
+        relaxa_linha(dist, g->matriz_adj[u], dist[u], nv);
     }
 
     free(usado);
@@ -587,5 +1233,682 @@ int calcular_diametro(grafo *g, int *componente, int tam) {
     return max_diam;
 }
 
+// Compara limites de diametro, usado em limites_diametros
+int cmp_limites(const void *a, const void *b) {
+  const LimitesDiametro *la = a;
+  const LimitesDiametro *lb = b;
+  if (la->inferior != lb->inferior) return (la->inferior < lb->inferior) ? -1 : 1;
+  if (la->superior != lb->superior) return (la->superior < lb->superior) ? -1 : 1;
+  return 0;
+}
+
+// Aloca um grafo vazio com o nome dado (copiado; pode ser NULL)
+grafo *cria_grafo(const char *nome) {
+  grafo *g = malloc(sizeof(grafo));
+  if (!g){perror("Erro ao alocar grafo\n"); exit(-1);}
+  g->nome = nome ? strdup(nome) : NULL;
+  g->vertices = NULL;
+  g->arestas = NULL;
+  g->cap_arestas = 0;
+  g->hash_arestas = NULL;
+  g->cap_hash = 0;
+  g->na = 0;
+  g->hash_vertices = NULL;
+  g->cap_hash_vertices = 0;
+  g->nv = 0;
+  g->matriz_adj = NULL;
+  g->matriz_bloco = NULL;
+  g->matriz_passo = 0;
+  g->adj_inicio = NULL;
+  g->adj_vizinho = NULL;
+  g->adj_peso = NULL;
+  g->busca = NULL;
+  g->externo = NULL;
+  g->politica_paralelas = politica_paralelas;
+  g->politica_lacos = politica_lacos;
+  g->diam_aproximado = 0;
+  g->diam_max_buscas = 0;
+  g->diam_max_segundos = 0;
+  return g;
+}
+
+// Monta a matriz e as listas de adjacencia depois que vertices e arestas foram inseridos
+void finaliza_grafo(grafo *g) {
+  //A tabela de espalhamento so serve para fundir arestas durante a construcao
+  free(g->hash_arestas);
+  g->hash_arestas = NULL;
+  g->cap_hash = 0;
+
+  //Ordena as arestas pelo par de ids e devolve a sobra do vetor
+  if (g->na) qsort(g->arestas, g->na, sizeof(Aresta), cmp_arestas);
+  if (g->na && g->na < g->cap_arestas) {
+    Aresta *justo = realloc(g->arestas, sizeof(Aresta) * g->na);
+    if (justo) {
+      g->arestas = justo;
+      g->cap_arestas = g->na;
+    }
+  }
+
+  //Cria um matriz de adjacencia nv x nv
+  aloca_matriz(g);
+  
+  //Preenche a matriz (cria ela espelhada)
+  for (unsigned int i = 0; i < g->na; i++){
+    Aresta *a = &g->arestas[i];
+    //Quando uma aresta nao tem peso, insere o valor 1 na matriz para indicar que existe uma aresta ali
+    if(!a->peso){ 
+      g->matriz_adj[a->v1->id][a->v2->id] = 1;
+      g->matriz_adj[a->v2->id][a->v1->id] = 1;  
+    }
+    else{
+      g->matriz_adj[a->v1->id][a->v2->id] = a->peso;
+      g->matriz_adj[a->v2->id][a->v1->id] = a->peso;
+    }
+  }
+
+  monta_listas_adj(g);
+}
+
+// Aloca a matriz de adjacencia nv x nv zerada em um unico bloco alinhado
+// matriz_adj[i] aponta para a linha i dentro do bloco
+void aloca_matriz(grafo *g) {
+  unsigned int nv = g->nv;
+  g->matriz_passo = (nv + 7u) & ~7u;
+
+  size_t tam = (size_t)nv * g->matriz_passo * sizeof(int);
+  void *bloco = NULL;
+  if (posix_memalign(&bloco, ALINHAMENTO_MATRIZ, tam ? tam : ALINHAMENTO_MATRIZ)){
+    perror("Erro ao alocar matriz de adjacencia\n"); exit(-1);
+  }
+  memset(bloco, 0, tam);
+  g->matriz_bloco = bloco;
+
+  g->matriz_adj = malloc(sizeof(int *) * (nv + 1));
+  if(!g->matriz_adj){perror("Erro ao alocar matriz de adjacencia\n"); exit(-1);}
+  for (unsigned int i = 0; i < nv; i++)
+    g->matriz_adj[i] = g->matriz_bloco + (size_t)i * g->matriz_passo;
+}
+
+// monta as listas de adjacencia (CSR) a partir da matriz
+void monta_listas_adj(grafo *g) {
+  unsigned int nv = g->nv;
+  g->adj_inicio = malloc(sizeof(unsigned int) * (nv + 1));
+  if (!g->adj_inicio){perror("Erro ao alocar listas de adjacencia\n"); exit(-1);}
+
+  //Conta os vizinhos de cada vertice
+  unsigned int total = 0;
+  for (unsigned int i = 0; i < nv; i++) {
+    g->adj_inicio[i] = total;
+    for (unsigned int j = 0; j < nv; j++)
+      if (g->matriz_adj[i][j] > 0) total++;
+  }
+  g->adj_inicio[nv] = total;
+
+  g->adj_vizinho = malloc(sizeof(unsigned int) * (total + 1));
+  g->adj_peso = malloc(sizeof(int) * (total + 1));
+  if (!g->adj_vizinho || !g->adj_peso){perror("Erro ao alocar listas de adjacencia\n"); exit(-1);}
+
+  //Preenche na mesma ordem da contagem
+  unsigned int k = 0;
+  for (unsigned int i = 0; i < nv; i++)
+    for (unsigned int j = 0; j < nv; j++)
+      if (g->matriz_adj[i][j] > 0) {
+        g->adj_vizinho[k] = j;
+        g->adj_peso[k] = g->matriz_adj[i][j];
+        k++;
+      }
+}
+
+// soma duas distancias nao negativas, saturando em INF
+int soma_saturada(int a, int b) {
+  if (a == INF || b == INF || a > INF - b) return INF;
+  return a + b;
+}
+
+// aloca o estado de busca ponto a ponto de g
+Busca *cria_busca(grafo *g) {
+  unsigned int nv = g->nv;
+  //cada aresta relaxada insere no maximo uma entrada no heap, mais a da raiz
+  unsigned int cap = g->adj_inicio[nv] + 1;
+
+  Busca *b = malloc(sizeof(Busca));
+  if (!b){perror("Erro ao alocar estado de busca\n"); exit(-1);}
+  b->epoca = 0;
+  for (int lado = 0; lado < 2; lado++) {
+    b->marca[lado] = calloc(nv + 1, sizeof(unsigned int));
+    b->fechado[lado] = calloc(nv + 1, sizeof(unsigned int));
+    b->dist[lado] = malloc(sizeof(int) * (nv + 1));
+    b->heap[lado] = malloc(sizeof(ItemHeap) * cap);
+    b->tam_heap[lado] = 0;
+    if (!b->marca[lado] || !b->fechado[lado] || !b->dist[lado] || !b->heap[lado]){
+      perror("Erro ao alocar estado de busca\n"); exit(-1);
+    }
+  }
+  return b;
+}
+
+// libera o estado de busca
+void destroi_busca(Busca *b) {
+  if (!b) return;
+  for (int lado = 0; lado < 2; lado++) {
+    free(b->marca[lado]);
+    free(b->fechado[lado]);
+    free(b->dist[lado]);
+    free(b->heap[lado]);
+  }
+  free(b);
+}
+
+// invalida todas as distancias do estado de busca em O(1)
+// so quando o contador de epocas da a volta e preciso zerar as marcas
+void nova_epoca(Busca *b, unsigned int nv) {
+  b->epoca++;
+  if (b->epoca == 0) {
+    for (int lado = 0; lado < 2; lado++) {
+      memset(b->marca[lado], 0, sizeof(unsigned int) * (nv + 1));
+      memset(b->fechado[lado], 0, sizeof(unsigned int) * (nv + 1));
+    }
+    b->epoca = 1;
+  }
+  b->tam_heap[0] = b->tam_heap[1] = 0;
+}
+
+// insere (dist, v) no heap minimo
+void heap_insere(ItemHeap *h, unsigned int *tam, int dist, unsigned int v) {
+  unsigned int i = (*tam)++;
+  while (i > 0) {
+    unsigned int pai = (i - 1) / 2;
+    if (h[pai].dist <= dist) break;
+    h[i] = h[pai];
+    i = pai;
+  }
+  h[i].dist = dist;
+  h[i].v = v;
+}
+
+// remove e devolve o item de menor distancia do heap
+ItemHeap heap_remove(ItemHeap *h, unsigned int *tam) {
+  ItemHeap topo = h[0];
+  ItemHeap ultimo = h[--(*tam)];
+  unsigned int n = *tam, i = 0;
+  while (2 * i + 1 < n) {
+    unsigned int f = 2 * i + 1;
+    if (f + 1 < n && h[f + 1].dist < h[f].dist) f++;
+    if (ultimo.dist <= h[f].dist) break;
+    h[i] = h[f];
+    i = f;
+  }
+  if (n > 0) h[i] = ultimo;
+  return topo;
+}
+
+// Dijkstra completo a partir de origem usando o lado 0 do estado de busca
+// as distancias ficam em g->busca->dist[0] para os vertices do componente
+// se componente nao e NULL, recebe os vertices alcancados e *tam a quantidade
+// devolve a excentricidade da origem
+int varredura(grafo *g, unsigned int origem, unsigned int *componente, unsigned int *tam) {
+  if (!g->busca) g->busca = cria_busca(g);
+  Busca *b = g->busca;
+  nova_epoca(b, g->nv);
+
+  b->dist[0][origem] = 0;
+  b->marca[0][origem] = b->epoca;
+  heap_insere(b->heap[0], &b->tam_heap[0], 0, origem);
+
+  int exc = 0;
+  while (b->tam_heap[0]) {
+    ItemHeap it = heap_remove(b->heap[0], &b->tam_heap[0]);
+    unsigned int v = it.v;
+    if (b->fechado[0][v] == b->epoca || it.dist > b->dist[0][v]) continue;
+    b->fechado[0][v] = b->epoca;
+
+    if (componente) componente[(*tam)++] = v;
+    if (it.dist > exc) exc = it.dist;
+
+    for (unsigned int k = g->adj_inicio[v]; k < g->adj_inicio[v + 1]; k++) {
+      unsigned int u = g->adj_vizinho[k];
+      int nd = soma_saturada(it.dist, g->adj_peso[k]);
+      if (b->marca[0][u] != b->epoca || nd < b->dist[0][u]) {
+        b->dist[0][u] = nd;
+        b->marca[0][u] = b->epoca;
+        heap_insere(b->heap[0], &b->tam_heap[0], nd, u);
+      }
+    }
+  }
+  return exc;
+}
+
+//------------------------------------------------------------------------------
+// Kernels do Dijkstra denso
+//
+// as versoes escalares nao tem desvios para o compilador poder vetoriza-las;
+// as versoes SSE4.1/AVX2 sao escolhidas em tempo de execucao por nivel_simd()
+//
+// no relaxamento, uma posicao sem aresta (peso <= 0) vale INF e a soma satura:
+// du + min(w, INF - du) nunca passa de INF
+
+// indice do menor max(dist[i], mascara[i]) em [0, n), ou -1 se todos sao INF
+int argmin_mascarado(const int *dist, const int *mascara, unsigned int n) {
+#ifdef GRAFO_SIMD_X86
+  switch (nivel_simd()) {
+    case 2: return argmin_mascarado_avx2(dist, mascara, n);
+    case 1: return argmin_mascarado_sse41(dist, mascara, n);
+    default: break;
+  }
+#endif
+  return argmin_mascarado_escalar(dist, mascara, n);
+}
+
+// dist[v] = min(dist[v], du + linha[v]) para linha[v] > 0, saturando em INF
+void relaxa_linha(int *dist, const int *linha, int du, unsigned int n) {
+#ifdef GRAFO_SIMD_X86
+  switch (nivel_simd()) {
+    case 2: relaxa_linha_avx2(dist, linha, du, n); return;
+    case 1: relaxa_linha_sse41(dist, linha, du, n); return;
+    default: break;
+  }
+#endif
+  relaxa_linha_escalar(dist, linha, du, n);
+}
+
+int argmin_mascarado_escalar(const int *dist, const int *mascara, unsigned int n) {
+  int menor = INF, u = -1;
+  for (unsigned int i = 0; i < n; i++) {
+    int chave = (dist[i] > mascara[i]) ? dist[i] : mascara[i];
+    if (chave < menor) { menor = chave; u = (int)i; }
+  }
+  return u;
+}
+
+void relaxa_linha_escalar(int *dist, const int *linha, int du, unsigned int n) {
+  int limite = INF - du;
+  for (unsigned int v = 0; v < n; v++) {
+    int w = (linha[v] > 0) ? linha[v] : INF;
+    int cand = du + ((w < limite) ? w : limite);
+    dist[v] = (cand < dist[v]) ? cand : dist[v];
+  }
+}
+
+#ifdef GRAFO_SIMD_X86
+
+// nivel de SIMD disponivel na CPU, detectado uma unica vez
+int nivel_simd(void) {
+  static int nivel = -1;
+  if (nivel < 0) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) nivel = 2;
+    else if (__builtin_cpu_supports("sse4.1")) nivel = 1;
+    else nivel = 0;
+  }
+  return nivel;
+}
+
+__attribute__((target("sse4.1")))
+int argmin_mascarado_sse41(const int *dist, const int *mascara, unsigned int n) {
+  //primeira passada: menor chave
+  __m128i vmin = _mm_set1_epi32(INF);
+  unsigned int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i d = _mm_loadu_si128((const __m128i *)(const void *)(dist + i));
+    __m128i m = _mm_loadu_si128((const __m128i *)(const void *)(mascara + i));
+    vmin = _mm_min_epi32(vmin, _mm_max_epi32(d, m));
+  }
+  int buf[4];
+  _mm_storeu_si128((__m128i *)(void *)buf, vmin);
+  int menor = INF;
+  for (unsigned int k = 0; k < 4; k++) if (buf[k] < menor) menor = buf[k];
+  for (unsigned int k = i; k < n; k++) {
+    int chave = (dist[k] > mascara[k]) ? dist[k] : mascara[k];
+    if (chave < menor) menor = chave;
+  }
+  if (menor == INF) return -1;
+
+  //segunda passada: primeira posicao com a menor chave
+  __m128i alvo = _mm_set1_epi32(menor);
+  for (i = 0; i + 4 <= n; i += 4) {
+    __m128i d = _mm_loadu_si128((const __m128i *)(const void *)(dist + i));
+    __m128i m = _mm_loadu_si128((const __m128i *)(const void *)(mascara + i));
+    int bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_max_epi32(d, m), alvo)));
+    if (bits) return (int)(i + (unsigned int)__builtin_ctz((unsigned int)bits));
+  }
+  for (; i < n; i++)
+    if (((dist[i] > mascara[i]) ? dist[i] : mascara[i]) == menor) return (int)i;
+  return -1;
+}
+
+__attribute__((target("avx2")))
+int argmin_mascarado_avx2(const int *dist, const int *mascara, unsigned int n) {
+  //primeira passada: menor chave
+  __m256i vmin = _mm256_set1_epi32(INF);
+  unsigned int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i d = _mm256_loadu_si256((const __m256i *)(const void *)(dist + i));
+    __m256i m = _mm256_loadu_si256((const __m256i *)(const void *)(mascara + i));
+    vmin = _mm256_min_epi32(vmin, _mm256_max_epi32(d, m));
+  }
+  int buf[8];
+  _mm256_storeu_si256((__m256i *)(void *)buf, vmin);
+  int menor = INF;
+  for (unsigned int k = 0; k < 8; k++) if (buf[k] < menor) menor = buf[k];
+  for (unsigned int k = i; k < n; k++) {
+    int chave = (dist[k] > mascara[k]) ? dist[k] : mascara[k];
+    if (chave < menor) menor = chave;
+  }
+  if (menor == INF) return -1;
+
+  //segunda passada: primeira posicao com a menor chave
+  __m256i alvo = _mm256_set1_epi32(menor);
+  for (i = 0; i + 8 <= n; i += 8) {
+    __m256i d = _mm256_loadu_si256((const __m256i *)(const void *)(dist + i));
+    __m256i m = _mm256_loadu_si256((const __m256i *)(const void *)(mascara + i));
+    int bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_max_epi32(d, m), alvo)));
+    if (bits) return (int)(i + (unsigned int)__builtin_ctz((unsigned int)bits));
+  }
+  for (; i < n; i++)
+    if (((dist[i] > mascara[i]) ? dist[i] : mascara[i]) == menor) return (int)i;
+  return -1;
+}
+
+__attribute__((target("sse4.1")))
+void relaxa_linha_sse41(int *dist, const int *linha, int du, unsigned int n) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i inf = _mm_set1_epi32(INF);
+  __m128i vdu = _mm_set1_epi32(du);
+  __m128i limite = _mm_set1_epi32(INF - du);
+  unsigned int v = 0;
+  for (; v + 4 <= n; v += 4) {
+    __m128i w = _mm_loadu_si128((const __m128i *)(const void *)(linha + v));
+    w = _mm_blendv_epi8(inf, w, _mm_cmpgt_epi32(w, zero));
+    __m128i cand = _mm_add_epi32(vdu, _mm_min_epi32(w, limite));
+    __m128i d = _mm_loadu_si128((const __m128i *)(const void *)(dist + v));
+    _mm_storeu_si128((__m128i *)(void *)(dist + v), _mm_min_epi32(d, cand));
+  }
+  relaxa_linha_escalar(dist + v, linha + v, du, n - v);
+}
+
+__attribute__((target("avx2")))
+void relaxa_linha_avx2(int *dist, const int *linha, int du, unsigned int n) {
+  __m256i zero = _mm256_setzero_si256();
+  __m256i inf = _mm256_set1_epi32(INF);
+  __m256i vdu = _mm256_set1_epi32(du);
+  __m256i limite = _mm256_set1_epi32(INF - du);
+  unsigned int v = 0;
+  for (; v + 8 <= n; v += 8) {
+    __m256i w = _mm256_loadu_si256((const __m256i *)(const void *)(linha + v));
+    w = _mm256_blendv_epi8(inf, w, _mm256_cmpgt_epi32(w, zero));
+    __m256i cand = _mm256_add_epi32(vdu, _mm256_min_epi32(w, limite));
+    __m256i d = _mm256_loadu_si256((const __m256i *)(const void *)(dist + v));
+    _mm256_storeu_si256((__m256i *)(void *)(dist + v), _mm256_min_epi32(d, cand));
+  }
+  relaxa_linha_escalar(dist + v, linha + v, du, n - v);
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+// Modo externo
+
+// Cria o estado e o diretorio dos arquivos de g dentro de diretorio
+void inicia_externo(grafo *g, const char *diretorio, size_t orcamento) {
+  Externo *e = malloc(sizeof(Externo));
+  if (!e){perror("Erro ao alocar modo externo\n"); exit(-1);}
+  snprintf(e->dir, sizeof(e->dir), "%s/grafo_XXXXXX", diretorio);
+  if (!mkdtemp(e->dir)){perror("Erro ao criar diretorio do modo externo\n"); exit(-1);}
+
+  e->orcamento = orcamento;
+  size_t cap = orcamento / sizeof(ArestaExterna);
+  if (cap < 1) cap = 1;
+  if (cap > UINT_MAX) cap = UINT_MAX;
+  e->cap_buffer = (unsigned int)cap;
+  e->tam_buffer = 0;
+  e->buffer = malloc(sizeof(ArestaExterna) * cap);
+  if (!e->buffer){perror("Erro ao alocar buffer do modo externo\n"); exit(-1);}
+  e->n_runs = 0;
+  e->ordem = 0;
+  g->externo = e;
+}
+
+// Acumula uma aresta no buffer, gravando um run quando ele enche
+void adiciona_aresta_externa(grafo *g, Vertice *v1, Vertice *v2, int peso) {
+  if (v1 == v2 && g->politica_lacos == LACOS_DESCARTA) return;
+  Externo *e = g->externo;
+  ArestaExterna *a = &e->buffer[e->tam_buffer++];
+  a->v1 = (v1->id < v2->id) ? v1->id : v2->id;
+  a->v2 = (v1->id < v2->id) ? v2->id : v1->id;
+  a->peso = peso;
+  a->ordem = e->ordem++;
+  if (e->tam_buffer == e->cap_buffer) grava_run(g);
+}
+
+// Ordena o buffer, funde as repeticoes e grava como o proximo run
+void grava_run(grafo *g) {
+  Externo *e = g->externo;
+  if (!e->tam_buffer) return;
+
+  qsort(e->buffer, e->tam_buffer, sizeof(ArestaExterna), cmp_arestas_externas);
+  unsigned int n = 0;
+  for (unsigned int i = 0; i < e->tam_buffer; i++) {
+    if (n && e->buffer[n - 1].v1 == e->buffer[i].v1 && e->buffer[n - 1].v2 == e->buffer[i].v2)
+      funde_aresta_externa(g->politica_paralelas, &e->buffer[n - 1], &e->buffer[i]);
+    else
+      e->buffer[n++] = e->buffer[i];
+  }
+
+  char caminho[MAX_LINHA + 32];
+  caminho_externo(g, e->n_runs++, caminho, sizeof(caminho));
+  FILE *f = fopen(caminho, "wb");
+  if (!f || fwrite(e->buffer, sizeof(ArestaExterna), n, f) != n || fclose(f)){
+    perror("Erro ao gravar run do modo externo\n"); exit(-1);
+  }
+  e->tam_buffer = 0;
+}
+
+// Intercala todos os runs no arquivo final de arestas
+// com mais de MAX_RUNS_ABERTOS runs, intercala em grupos ate sobrarem poucos
+void finaliza_externo(grafo *g) {
+  Externo *e = g->externo;
+  grava_run(g);
+  free(e->buffer);
+  e->buffer = NULL;
+  e->cap_buffer = 0;
+
+  unsigned int ini = 0;
+  while (e->n_runs - ini > MAX_RUNS_ABERTOS) {
+    char caminho[MAX_LINHA + 32];
+    caminho_externo(g, e->n_runs, caminho, sizeof(caminho));
+    intercala_runs(g, ini, ini + MAX_RUNS_ABERTOS, caminho);
+    ini += MAX_RUNS_ABERTOS;
+    e->n_runs++;
+  }
+
+  char final[MAX_LINHA + 32];
+  caminho_externo(g, UINT_MAX, final, sizeof(final));
+  g->na = intercala_runs(g, ini, e->n_runs, final);
+}
+
+// Intercala os runs [ini, fim) em saida, fundindo repeticoes; remove os runs lidos
+unsigned int intercala_runs(grafo *g, unsigned int ini, unsigned int fim, const char *saida) {
+  unsigned int k = fim - ini;
+  FILE *entrada[MAX_RUNS_ABERTOS + 1];
+  ArestaExterna cabeca[MAX_RUNS_ABERTOS + 1];
+  int ativo[MAX_RUNS_ABERTOS + 1];
+  char caminho[MAX_LINHA + 32];
+
+  for (unsigned int r = 0; r < k; r++) {
+    caminho_externo(g, ini + r, caminho, sizeof(caminho));
+    entrada[r] = fopen(caminho, "rb");
+    if (!entrada[r]){perror("Erro ao abrir run do modo externo\n"); exit(-1);}
+    ativo[r] = fread(&cabeca[r], sizeof(ArestaExterna), 1, entrada[r]) == 1;
+  }
+  FILE *f = fopen(saida, "wb");
+  if (!f){perror("Erro ao gravar arestas do modo externo\n"); exit(-1);}
+
+  unsigned int n = 0;
+  int pendente = 0;
+  ArestaExterna atual;
+  while (1) {
+    //Menor cabeca entre os runs ainda ativos
+    int m = -1;
+    for (unsigned int r = 0; r < k; r++)
+      if (ativo[r] && (m == -1 || cmp_arestas_externas(&cabeca[r], &cabeca[m]) < 0)) m = (int)r;
+    if (m == -1) break;
+
+    if (pendente && atual.v1 == cabeca[m].v1 && atual.v2 == cabeca[m].v2)
+      funde_aresta_externa(g->politica_paralelas, &atual, &cabeca[m]);
+    else {
+      if (pendente) {
+        if (fwrite(&atual, sizeof(ArestaExterna), 1, f) != 1){perror("Erro ao gravar arestas do modo externo\n"); exit(-1);}
+        n++;
+      }
+      atual = cabeca[m];
+      pendente = 1;
+    }
+    ativo[m] = fread(&cabeca[m], sizeof(ArestaExterna), 1, entrada[m]) == 1;
+  }
+  if (pendente) {
+    if (fwrite(&atual, sizeof(ArestaExterna), 1, f) != 1){perror("Erro ao gravar arestas do modo externo\n"); exit(-1);}
+    n++;
+  }
+  if (fclose(f)){perror("Erro ao gravar arestas do modo externo\n"); exit(-1);}
+
+  for (unsigned int r = 0; r < k; r++) {
+    fclose(entrada[r]);
+    caminho_externo(g, ini + r, caminho, sizeof(caminho));
+    remove(caminho);
+  }
+  return n;
+}
+
+// caminho de um arquivo dentro do diretorio de g (run k, ou o final se k == UINT_MAX)
+void caminho_externo(grafo *g, unsigned int k, char *caminho, size_t tam) {
+  if (k == UINT_MAX) snprintf(caminho, tam, "%s/arestas", g->externo->dir);
+  else snprintf(caminho, tam, "%s/run_%u", g->externo->dir, k);
+}
+
+// aplica a politica de paralelas fundindo b em a
+// a->ordem passa a ser a da primeira ou da ultima ocorrencia, conforme a politica
+void funde_aresta_externa(unsigned int politica, ArestaExterna *a, const ArestaExterna *b) {
+  if ((politica == PARALELAS_PRIMEIRA && b->ordem < a->ordem) ||
+      (politica == PARALELAS_ULTIMA && b->ordem > a->ordem) ||
+      (politica == PARALELAS_MENOR && b->peso < a->peso) ||
+      (politica == PARALELAS_MAIOR && b->peso > a->peso))
+    a->peso = b->peso;
+  if (politica == PARALELAS_PRIMEIRA) {
+    if (b->ordem < a->ordem) a->ordem = b->ordem;
+  } else if (b->ordem > a->ordem) a->ordem = b->ordem;
+}
+
+// Compara arestas externas por (v1, v2, ordem)
+int cmp_arestas_externas(const void *a, const void *b) {
+  const ArestaExterna *aa = a;
+  const ArestaExterna *ab = b;
+  if (aa->v1 != ab->v1) return (aa->v1 < ab->v1) ? -1 : 1;
+  if (aa->v2 != ab->v2) return (aa->v2 < ab->v2) ? -1 : 1;
+  if (aa->ordem != ab->ordem) return (aa->ordem < ab->ordem) ? -1 : 1;
+  return 0;
+}
+
+// raiz de v no union-find com paridade; *par recebe a paridade de v em relacao a raiz
+// comprime o caminho, acertando a paridade de cada vertice para a da raiz
+unsigned int uf_raiz(unsigned int *pai, unsigned char *paridade, unsigned int v, unsigned int *par) {
+  unsigned int r = v, p = 0;
+  while (pai[r] != r) {
+    p ^= paridade[r];
+    r = pai[r];
+  }
+
+  unsigned int w = v, acumulada = p;
+  while (w != r && pai[w] != r) {
+    unsigned int prox = pai[w];
+    unsigned int pw = paridade[w];
+    pai[w] = r;
+    paridade[w] = (unsigned char)acumulada;
+    acumulada ^= pw;
+    w = prox;
+  }
+  *par = p;
+  return r;
+}
 
+// conta componentes com um union-find percorrendo o arquivo de arestas
+// se bip nao e NULL, recebe 1 se toda aresta liga vertices de paridades diferentes
+unsigned int uf_externo(grafo *g, unsigned int *bip) {
+  unsigned int nv = g->nv;
+  unsigned int *pai = malloc(sizeof(unsigned int) * (nv + 1));
+  unsigned char *paridade = calloc(nv + 1, sizeof(unsigned char));
+  unsigned char *posto = calloc(nv + 1, sizeof(unsigned char));
+  if (!pai || !paridade || !posto){perror("Erro ao alocar union-find\n"); exit(-1);}
+  for (unsigned int i = 0; i < nv; i++) pai[i] = i;
+
+  char caminho[MAX_LINHA + 32];
+  caminho_externo(g, UINT_MAX, caminho, sizeof(caminho));
+  FILE *f = fopen(caminho, "rb");
+  if (!f){perror("Erro ao abrir arestas do modo externo\n"); exit(-1);}
+
+  unsigned int componentes = nv;
+  if (bip) *bip = 1;
+  ArestaExterna a;
+  while (fread(&a, sizeof(ArestaExterna), 1, f) == 1) {
+    unsigned int pu, pv;
+    unsigned int ru = uf_raiz(pai, paridade, a.v1, &pu);
+    unsigned int rv = uf_raiz(pai, paridade, a.v2, &pv);
+    if (ru == rv) {
+      if (pu == pv && bip) { //aresta (ou laco) entre vertices de mesma cor
+        *bip = 0;
+        break;
+      }
+      continue;
+    }
+    //Une por posto; a paridade da raiz pendurada faz u e v terem cores opostas
+    if (posto[ru] > posto[rv]) {
+      unsigned int t = ru;
+      ru = rv;
+      rv = t;
+    }
+    pai[ru] = rv;
+    paridade[ru] = (unsigned char)(pu ^ pv ^ 1);
+    if (posto[ru] == posto[rv]) posto[rv]++;
+    componentes--;
+  }
+  fclose(f);
 
+  free(pai);
+  free(paridade);
+  free(posto);
+  return componentes;
+}
+
+// imprime as arestas do arquivo, no formato de imprime_grafo
+void imprime_arestas_externo(grafo *g) {
+  Vertice **vert = vetor_vertices(g);
+  char caminho[MAX_LINHA + 32];
+  caminho_externo(g, UINT_MAX, caminho, sizeof(caminho));
+  FILE *f = fopen(caminho, "rb");
+  if (!f){perror("Erro ao abrir arestas do modo externo\n"); exit(-1);}
+
+  printf("Arestas:\n");
+  ArestaExterna a;
+  while (fread(&a, sizeof(ArestaExterna), 1, f) == 1)
+    printf("  %s -- %s (%d)\n", vert[a.v1]->nome, vert[a.v2]->nome, a.peso);
+  fclose(f);
+  free(vert);
+}
+
+// componentes do grafo no modo externo
+unsigned int n_componentes_externo(grafo *g) {
+  return uf_externo(g, NULL);
+}
+
+// bipartição do grafo no modo externo
+unsigned int bipartido_externo(grafo *g) {
+  unsigned int bip;
+  uf_externo(g, &bip);
+  return bip;
+}
+
+// informa em stderr que a operacao precisa do grafo em memoria
+int recusa_externo(grafo *g, const char *operacao) {
+  if (!g || !g->externo) return 0;
+  fprintf(stderr, "%s: operacao nao suportada no modo externo (o grafo nao esta em memoria)\n", operacao);
+  return 1;
+}
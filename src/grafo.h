@@ -4,6 +4,16 @@
 #define MAX_LINHA 2048
 #define INF INT_MAX
 
+// politicas para arestas paralelas (mesmo par de vertices), ver configura_arestas
+#define PARALELAS_PRIMEIRA 0  //fica o peso da primeira ocorrencia na entrada
+#define PARALELAS_ULTIMA   1  //fica o peso da ultima ocorrencia na entrada
+#define PARALELAS_MENOR    2  //fica o menor peso
+#define PARALELAS_MAIOR    3  //fica o maior peso
+
+// politicas para lacos (aresta de um vertice para ele mesmo)
+#define LACOS_MANTEM   0
+#define LACOS_DESCARTA 1
+
 
 //------------------------------------------------------------------------------
 // estrutura de dados para representar um grafo
@@ -18,10 +28,9 @@ typedef struct vertice {
 } Vertice;
 
 typedef struct aresta {
-    Vertice *v1;
+    Vertice *v1;    //vertice de menor id
     Vertice *v2;
     int peso;
-    struct aresta *prox;
 } Aresta;
 
 typedef struct grafo {
@@ -29,12 +38,109 @@ typedef struct grafo {
     unsigned int nv, na; 
     char *nome;
     Vertice *vertices;
+
+    //tabela de espalhamento (nome -> vertice) com enderecamento aberto,
+    //mantida com ocupacao de no maximo 1/2; usada por busca_ou_adiciona_vertice
+    Vertice **hash_vertices;
+    unsigned int cap_hash_vertices;
+
+    //vetor com as na arestas distintas, ordenado por (id de v1, id de v2)
+    //arestas paralelas sao fundidas na insercao (ver configura_arestas)
     Aresta *arestas;
+    unsigned int cap_arestas;
+
+    //tabela de espalhamento (par de ids -> indice em arestas) usada so
+    //durante a construcao; liberada por finaliza_grafo
+    unsigned int *hash_arestas;
+    unsigned int cap_hash;
 
     //matriz de adjacencia inteira com os pesos das arestas
+    //as linhas apontam para um unico bloco alinhado (matriz_bloco), cada uma
+    //com matriz_passo inteiros (nv arredondado para multiplo de 8)
     int **matriz_adj;      
+    int *matriz_bloco;
+    unsigned int matriz_passo;
+
+    //listas de adjacencia compactas (CSR) montadas a partir da matriz
+    //os vizinhos de v estao em adj_vizinho[adj_inicio[v] .. adj_inicio[v+1]-1]
+    unsigned int *adj_inicio;
+    unsigned int *adj_vizinho;
+    int *adj_peso;
+
+    //estado de busca reaproveitado entre consultas de distancia (criado sob demanda)
+    struct busca *busca;
+
+    //estado do modo externo (ver configura_modo_externo); NULL no modo normal
+    struct externo *externo;
+
+    //politicas de arestas, copiadas da configuracao global em cria_grafo
+    unsigned int politica_paralelas;
+    unsigned int politica_lacos;
+
+    //modo de calculo dos diametros (ver configura_diametros)
+    unsigned int diam_aproximado;
+    unsigned int diam_max_buscas;
+    double diam_max_segundos;
 } grafo;
 
+//------------------------------------------------------------------------------
+// modo externo: as arestas ficam em arquivos num diretorio temporario
+//
+// durante a leitura as arestas sao acumuladas em um buffer limitado pelo
+// orcamento; cada buffer cheio e ordenado, tem as repeticoes fundidas e vira
+// um "run" em disco; ao fim da leitura os runs sao intercalados em um unico
+// arquivo ordenado, que as consultas percorrem sequencialmente
+
+typedef struct aresta_externa {
+    unsigned int v1, v2;    //ids, v1 <= v2
+    int peso;
+    unsigned int ordem;     //posicao na entrada, usada pelas politicas PARALELAS_PRIMEIRA e _ULTIMA
+} ArestaExterna;
+
+typedef struct externo {
+    char dir[MAX_LINHA];      //diretorio criado para os arquivos deste grafo
+    size_t orcamento;         //bytes do buffer, copiado da configuracao ao criar o grafo
+    ArestaExterna *buffer;    //arestas ainda nao gravadas (so durante a leitura)
+    unsigned int tam_buffer, cap_buffer;
+    unsigned int n_runs;      //runs gravados ate agora
+    unsigned int ordem;       //numero de arestas lidas
+} Externo;
+
+//------------------------------------------------------------------------------
+// limites para o diametro de um componente no modo aproximado
+//
+// o diametro exato d do componente satisfaz inferior <= d <= superior
+// buscas e o numero de travessias (Dijkstra completos) usadas no componente
+
+typedef struct limites_diametro {
+    int inferior;
+    int superior;
+    unsigned int buscas;
+} LimitesDiametro;
+
+//------------------------------------------------------------------------------
+// estado das buscas ponto a ponto
+//
+// os vetores sao alocados uma vez por grafo e reaproveitados entre consultas
+// uma posicao so e valida se a sua marca for igual a epoca atual, entao
+// iniciar uma nova consulta custa O(1) em vez de O(V)
+//
+// o indice [0] e a busca a partir da origem e o [1] a busca a partir do destino
+
+typedef struct item_heap {
+    int dist;
+    unsigned int v;
+} ItemHeap;
+
+typedef struct busca {
+    unsigned int epoca;
+    unsigned int *marca[2];    //epoca em que dist[lado][v] foi escrita
+    unsigned int *fechado[2];  //epoca em que v teve a distancia fixada
+    int *dist[2];
+    ItemHeap *heap[2];         //heaps minimos com remocao preguicosa
+    unsigned int tam_heap[2];
+} Busca;
+
 //------------------------------------------------------------------------------
 // lê um grafo de f e o devolve
 //
@@ -76,6 +182,46 @@ três
 
 grafo *le_grafo(FILE *f);
 
+//------------------------------------------------------------------------------
+// configura como os próximos grafos lidos/criados tratam arestas repetidas
+//
+// arestas paralelas (mesmo par de vértices, em qualquer ordem) são fundidas em
+// uma só, com o peso escolhido por paralelas (PARALELAS_PRIMEIRA, padrão,
+// PARALELAS_ULTIMA, PARALELAS_MENOR ou PARALELAS_MAIOR). o padrão mantém o
+// peso que a matriz de adjacência sempre guardou; a diferença em relação à
+// versão anterior é que n_arestas() agora conta só as arestas distintas
+//
+// lacos indica se arestas de um vértice para ele mesmo são mantidas
+// (LACOS_MANTEM, padrão) ou descartadas (LACOS_DESCARTA); um grafo com laço
+// não é bipartido
+//
+// a configuração é global porque le_grafo(FILE *) tem assinatura fixa e não
+// recebe opções; cada grafo copia as políticas ao ser criado, então mudar a
+// configuração depois não afeta grafos já existentes
+
+void configura_arestas(unsigned int paralelas, unsigned int lacos);
+
+//------------------------------------------------------------------------------
+// liga o modo externo para os próximos grafos lidos por le_grafo()
+//
+// as arestas são gravadas em arquivos dentro de um subdiretório criado em
+// diretorio (removido por destroi_grafo()); orcamento é o número de bytes que
+// o buffer de arestas pode ocupar na memória. só os vértices e vetores de
+// tamanho O(V) ficam residentes
+//
+// no modo externo, n_vertices(), n_arestas(), n_componentes() e bipartido()
+// funcionam normalmente, percorrendo o arquivo de arestas; as demais consultas
+// precisam da matriz de adjacência e falham com uma mensagem em stderr,
+// devolvendo NULL (ou INF nas distâncias)
+//
+// diretorio NULL desliga o modo externo
+//
+// assim como em configura_arestas(), a configuração é global porque
+// le_grafo(FILE *) tem assinatura fixa; cada grafo lido guarda o seu
+// diretório e orçamento, então mudar a configuração depois não o afeta
+
+void configura_modo_externo(const char *diretorio, size_t orcamento);
+
 //------------------------------------------------------------------------------
 // desaloca toda a estrutura de dados alocada em g
 //
@@ -129,6 +275,78 @@ char *vertices_corte(grafo *g);
 
 char *arestas_corte(grafo *g);
 
+//------------------------------------------------------------------------------
+// devolve a distância entre os vértices de ids origem e destino em g
+// (o id de um vértice é o campo id da sua estrutura Vertice)
+//
+// usa Dijkstra bidirecional sobre as listas de adjacência; o estado da busca
+// fica guardado em g e é reaproveitado pelas consultas seguintes
+//
+// devolve INF se os vértices estão em componentes diferentes
+
+int distancia(grafo *g, unsigned int origem, unsigned int destino);
+
+//------------------------------------------------------------------------------
+// devolve um novo grafo com a árvore de pontes de g
+//
+// cada vértice é um componente 2-aresta-conexo de g (o que sobra ao remover as
+// arestas de corte), com o nome alfabeticamente menor entre os seus vértices;
+// cada aresta é uma aresta de corte de g, com o mesmo peso
+//
+// o grafo devolvido é uma floresta (uma árvore por componente de g), tem nome
+// "<nome de g>_pontes" e deve ser desalocado com destroi_grafo()
+
+grafo *arvore_pontes(grafo *g);
+
+//------------------------------------------------------------------------------
+// devolve um novo grafo com a árvore de blocos e vértices de corte de g
+//
+// há um vértice "bloco_<k>" (k = 1, 2, ...) para cada bloco (componente
+// biconexo) de g, incluindo vértices isolados ou só com laço, e um vértice com
+// o mesmo nome para cada vértice de corte de g; cada vértice de corte é ligado
+// por uma aresta sem peso a cada bloco que o contém
+//
+// se o nome de algum vértice de corte começa com "bloco_", o prefixo dos blocos
+// ganha mais "_" ("bloco__<k>", ...) até não haver conflito de nomes
+//
+// o grafo devolvido é uma floresta, tem nome "<nome de g>_blocos" e deve ser
+// desalocado com destroi_grafo()
+
+grafo *arvore_blocos(grafo *g);
+
+//------------------------------------------------------------------------------
+// devolve a excentricidade do vértice de id v em g, isto é, a maior distância
+// de v a um vértice do seu componente
+//
+// devolve INF se v não é um id válido
+
+int excentricidade(grafo *g, unsigned int v);
+
+//------------------------------------------------------------------------------
+// configura o cálculo dos diâmetros de g
+//
+// se aproximado é 0 (padrão), diametros() devolve os diâmetros exatos
+// caso contrário, diametros() usa limites_diametros() e cada componente aparece
+// na "string" como "inferior..superior" (ou só o valor, se os limites coincidem)
+//
+// max_buscas limita o número de travessias por componente e max_segundos o
+// tempo total (de relógio) da chamada; 0 em qualquer um deles indica sem limite
+// todo componente recebe ao menos uma travessia, mesmo com o orçamento esgotado
+
+void configura_diametros(grafo *g, unsigned int aproximado, unsigned int max_buscas, double max_segundos);
+
+//------------------------------------------------------------------------------
+// devolve um vetor com limites inferior e superior do diâmetro de cada
+// componente de g, ordenado pelos limites, e guarda em *n o número de componentes
+//
+// refina os limites com travessias a partir de vértices escolhidos (varredura
+// dupla seguida de limites de excentricidade) até que eles coincidam ou o
+// orçamento de configura_diametros() se esgote; sem orçamento o resultado é exato
+//
+// o vetor devolvido deve ser liberado com free()
+
+LimitesDiametro *limites_diametros(grafo *g, unsigned int *n);
+
 
 
 //funções auxiliares
@@ -152,6 +370,8 @@ void dfs_matriz(grafo *g, int v, int *visitado, int *componente, int *tam);
 int calcular_diametro(grafo *g, int *componente, int tam);
 
 
+// imprime vértices, arestas e matriz de adjacência de g
+// no modo externo imprime as arestas do arquivo, em ordem de id, sem a matriz
 void imprime_grafo(grafo *g);
 
 
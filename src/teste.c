@@ -1,33 +1,159 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include "grafo.h"
 
 //------------------------------------------------------------------------------
-int main(void) {
+// uso: teste [opções] < grafo
+//
+//   -x   imprime também as distâncias entre todos os pares de vértices
+//   -a N diâmetros no modo aproximado com até N travessias por componente
+//        (0 = sem limite); imprime também os limites e as excentricidades
+//   -t   imprime também o relatório da árvore de pontes e da árvore de blocos
+//   -p P política para arestas paralelas: primeira (padrão), ultima, menor ou maior
+//   -l   descarta laços
+//   -e D B lê o grafo no modo externo, com arquivos em D e buffer de B bytes
+//   -i   imprime também o grafo (imprime_grafo)
+//
+// sem opções a saída é só o relatório padrão do trabalho
 
-  grafo *g = le_grafo(stdin);
-  char *s;
+//------------------------------------------------------------------------------
+// compara vértices pelo nome, para imprimir em ordem alfabética
+static int cmp_vertice(const void *a, const void *b) {
+  const Vertice * const *va = a;
+  const Vertice * const *vb = b;
+  return strcmp((*va)->nome, (*vb)->nome);
+}
 
+//------------------------------------------------------------------------------
+// devolve um vetor com os vértices de g em ordem alfabética
+static Vertice **vertices_ordenados(grafo *g) {
+  Vertice **v = malloc(sizeof(Vertice *) * (n_vertices(g) + 1));
+  unsigned int n = 0;
+  for (Vertice *u = g->vertices; u; u = u->prox) v[n++] = u;
+  qsort(v, n, sizeof(Vertice *), cmp_vertice);
+  return v;
+}
+
+//------------------------------------------------------------------------------
+// imprime "a-b=d" para cada par de vértices a < b (inf se não há caminho)
+static void imprime_distancias(grafo *g) {
+  Vertice **v = vertices_ordenados(g);
+  unsigned int n = n_vertices(g);
+
+  printf("distâncias:");
+  for (unsigned int i = 0; i < n; i++)
+    for (unsigned int j = i + 1; j < n; j++) {
+      int d = distancia(g, v[i]->id, v[j]->id);
+      if (d == INF) printf(" %s-%s=inf", v[i]->nome, v[j]->nome);
+      else printf(" %s-%s=%d", v[i]->nome, v[j]->nome, d);
+    }
+  printf("\n");
+  free(v);
+}
+
+//------------------------------------------------------------------------------
+// imprime os limites de diâmetro de cada componente e a excentricidade de cada vértice
+static void imprime_limites(grafo *g) {
+  unsigned int n;
+  LimitesDiametro *lim = limites_diametros(g, &n);
+  printf("limites:");
+  for (unsigned int i = 0; i < n; i++)
+    printf(" %d..%d/%u", lim[i].inferior, lim[i].superior, lim[i].buscas);
+  printf("\n");
+  free(lim);
+
+  Vertice **v = vertices_ordenados(g);
+  printf("excentricidades:");
+  for (unsigned int i = 0; i < n_vertices(g); i++)
+    printf(" %s=%d", v[i]->nome, excentricidade(g, v[i]->id));
+  printf("\n");
+  free(v);
+}
+
+//------------------------------------------------------------------------------
+// imprime "rotulo: s" e libera s; NULL é uma consulta recusada (modo externo)
+static void imprime_resultado(const char *rotulo, char *s) {
+  printf("%s: %s\n", rotulo, s ? s : "não suportado");
+  free(s);
+}
+
+//------------------------------------------------------------------------------
+// relatório padrão do trabalho
+static void relatorio(grafo *g) {
   printf("grafo: %s\n", nome(g));
 
 
   printf("%d vertices\n", n_vertices(g));
   printf("%d arestas\n", n_arestas(g));
-  
+
   //imprime_grafo(g);
 
   printf("%d componentes\n", n_componentes(g));
 
   printf("%sbipartido\n", bipartido(g) ? "" : "não ");
 
-  printf("diâmetros: %s\n", s=diametros(g));
-  free(s);
+  imprime_resultado("diâmetros", diametros(g));
+  imprime_resultado("vértices de corte", vertices_corte(g));
+  imprime_resultado("arestas de corte", arestas_corte(g));
+}
 
-  printf("vértices de corte: %s\n", s=vertices_corte(g));
-  free(s);
+//------------------------------------------------------------------------------
+// relatório de uma árvore derivada de g (NULL se a consulta foi recusada)
+static void relatorio_arvore(const char *rotulo, grafo *t) {
+  if (!t) {
+    printf("%s: não suportado\n", rotulo);
+    return;
+  }
+  relatorio(t);
+  destroi_grafo(t);
+}
 
-  printf("arestas de corte: %s\n", s=arestas_corte(g));
-  free(s);
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+
+  int extras = 0, aproximado = 0, arvores = 0, imprime = 0;
+  unsigned int max_buscas = 0;
+  unsigned int paralelas = PARALELAS_PRIMEIRA, lacos = LACOS_MANTEM;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-x") == 0) extras = 1;
+    else if (strcmp(argv[i], "-t") == 0) arvores = 1;
+    else if (strcmp(argv[i], "-l") == 0) lacos = LACOS_DESCARTA;
+    else if (strcmp(argv[i], "-i") == 0) imprime = 1;
+    else if (strcmp(argv[i], "-e") == 0 && i + 2 < argc) {
+      configura_modo_externo(argv[i + 1], (size_t)strtoul(argv[i + 2], NULL, 10));
+      i += 2;
+    }
+    else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+      i++;
+      if (strcmp(argv[i], "primeira") == 0) paralelas = PARALELAS_PRIMEIRA;
+      else if (strcmp(argv[i], "ultima") == 0) paralelas = PARALELAS_ULTIMA;
+      else if (strcmp(argv[i], "menor") == 0) paralelas = PARALELAS_MENOR;
+      else if (strcmp(argv[i], "maior") == 0) paralelas = PARALELAS_MAIOR;
+      else { fprintf(stderr, "política desconhecida: %s\n", argv[i]); return 1; }
+    }
+    else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+      aproximado = 1;
+      max_buscas = (unsigned int)strtoul(argv[++i], NULL, 10);
+    }
+    else { fprintf(stderr, "opção desconhecida: %s\n", argv[i]); return 1; }
+  }
+
+  configura_arestas(paralelas, lacos);
+  grafo *g = le_grafo(stdin);
+  if (aproximado) configura_diametros(g, 1, max_buscas, 0);
+
+  relatorio(g);
+
+  if (imprime) imprime_grafo(g);
+  if (extras) imprime_distancias(g);
+  if (aproximado) imprime_limites(g);
+
+  if (arvores) {
+    relatorio_arvore("árvore de pontes", arvore_pontes(g));
+    relatorio_arvore("árvore de blocos", arvore_blocos(g));
+  }
 
   return ! destroi_grafo(g);
 }
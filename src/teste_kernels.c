@@ -0,0 +1,129 @@
+/*
+  Teste dos kernels do Dijkstra denso (argmin_mascarado e relaxa_linha).
+  Compara cada versao disponivel (despacho, escalar, SSE4.1, AVX2) com uma
+  referencia calculada em long long, sobre vetores aleatorios de tamanhos
+  variados (inclusive nao multiplos de 4 e 8), com empates e pesos perto de INF.
+
+  Compilado normalmente e com -DGRAFO_SEM_SIMD (ver o alvo test do makefile).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "grafo.h"
+
+#if !defined(GRAFO_SEM_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRAFO_SIMD_X86 1
+#endif
+
+#define MAX_N 67
+#define CASOS 20000
+
+// kernels internos de grafo.c
+int argmin_mascarado(const int *dist, const int *mascara, unsigned int n);
+int argmin_mascarado_escalar(const int *dist, const int *mascara, unsigned int n);
+void relaxa_linha(int *dist, const int *linha, int du, unsigned int n);
+void relaxa_linha_escalar(int *dist, const int *linha, int du, unsigned int n);
+#ifdef GRAFO_SIMD_X86
+int argmin_mascarado_sse41(const int *dist, const int *mascara, unsigned int n);
+int argmin_mascarado_avx2(const int *dist, const int *mascara, unsigned int n);
+void relaxa_linha_sse41(int *dist, const int *linha, int du, unsigned int n);
+void relaxa_linha_avx2(int *dist, const int *linha, int du, unsigned int n);
+#endif
+
+typedef int (*fn_argmin)(const int *, const int *, unsigned int);
+typedef void (*fn_relaxa)(int *, const int *, int, unsigned int);
+
+//------------------------------------------------------------------------------
+// gerador deterministico, para o teste ser reproduzivel
+static unsigned int semente = 12345u;
+static unsigned int sorteia(unsigned int n) {
+  semente = semente * 1103515245u + 12345u;
+  return (semente >> 8) % n;
+}
+
+// distancia aleatoria: valores pequenos (para haver empates), INF e perto de INF
+static int sorteia_dist(void) {
+  switch (sorteia(8)) {
+    case 0: return INF;
+    case 1: return INF - (int)sorteia(4);
+    case 2: return INF / 2 + (int)sorteia(4);
+    default: return (int)sorteia(6);
+  }
+}
+
+// peso aleatorio: sem aresta (0 ou negativo), pequeno ou enorme
+static int sorteia_peso(void) {
+  switch (sorteia(8)) {
+    case 0: return 0;
+    case 1: return -(int)sorteia(5) - 1;
+    case 2: return INF;
+    case 3: return INF - (int)sorteia(4);
+    default: return (int)sorteia(50) + 1;
+  }
+}
+
+//------------------------------------------------------------------------------
+static int ref_argmin(const int *dist, const int *mascara, unsigned int n) {
+  int u = -1;
+  long long menor = INF;
+  for (unsigned int i = 0; i < n; i++) {
+    long long chave = (dist[i] > mascara[i]) ? dist[i] : mascara[i];
+    if (chave < menor) { menor = chave; u = (int)i; }
+  }
+  return u;
+}
+
+static void ref_relaxa(int *dist, const int *linha, int du, unsigned int n) {
+  for (unsigned int v = 0; v < n; v++) {
+    if (linha[v] <= 0) continue;
+    long long cand = (long long)du + linha[v];
+    if (cand > INF) cand = INF;
+    if (cand < dist[v]) dist[v] = (int)cand;
+  }
+}
+
+//------------------------------------------------------------------------------
+// testa uma versao dos kernels; devolve o numero de falhas
+static unsigned int testa(const char *nome, fn_argmin argmin, fn_relaxa relaxa) {
+  int dist[MAX_N + 1], mascara[MAX_N + 1], linha[MAX_N + 1], esperado[MAX_N + 1];
+  unsigned int falhas = 0;
+  semente = 12345u;
+
+  for (unsigned int caso = 0; caso < CASOS; caso++) {
+    unsigned int n = sorteia(MAX_N + 1);
+    for (unsigned int i = 0; i < n; i++) {
+      dist[i] = sorteia_dist();
+      mascara[i] = sorteia(3) ? 0 : INF;
+      linha[i] = sorteia_peso();
+    }
+
+    if (argmin(dist, mascara, n) != ref_argmin(dist, mascara, n)) falhas++;
+
+    int du = sorteia_dist();
+    if (du == INF) du = INF - 1;
+    for (unsigned int i = 0; i < n; i++) esperado[i] = dist[i];
+    ref_relaxa(esperado, linha, du, n);
+    relaxa(dist, linha, du, n);
+    for (unsigned int i = 0; i < n; i++)
+      if (dist[i] != esperado[i]) { falhas++; break; }
+  }
+
+  printf("%-8s %s\n", nome, falhas ? "FALHOU" : "ok");
+  return falhas;
+}
+
+//------------------------------------------------------------------------------
+int main(void) {
+  unsigned int falhas = 0;
+  falhas += testa("despacho", argmin_mascarado, relaxa_linha);
+  falhas += testa("escalar", argmin_mascarado_escalar, relaxa_linha_escalar);
+#ifdef GRAFO_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.1"))
+    falhas += testa("sse4.1", argmin_mascarado_sse41, relaxa_linha_sse41);
+  if (__builtin_cpu_supports("avx2"))
+    falhas += testa("avx2", argmin_mascarado_avx2, relaxa_linha_avx2);
+#endif
+  return falhas != 0;
+}